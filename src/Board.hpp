@@ -1,19 +1,22 @@
 #pragma once
 
 #include "Piece.hpp"
+#include "Position.hpp"
 #include "bitboards.hpp"
 #include "movegen.hpp"
+#include <algorithm>
 #include <array>
-#include <stack>
+#include <stdexcept>
+#include <string_view>
 #include <string>
+#include <type_traits>
+#include <vector>
 
-const std::string STARTING_POSITION_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+constexpr std::string_view STARTING_POSITION_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
 struct BoardState
 {
     int8_t enPassantTargetSquare;
-    Bitboard whiteAttackingSquares;
-    Bitboard blackAttackingSquares;
     bool whiteCanShortCastle;
     bool whiteCanLongCastle;
     bool blackCanShortCastle;
@@ -22,151 +25,215 @@ struct BoardState
 };
 
 /**
- * Represents a full game (including previous states), including piece positions, side to move, castling rights, etc
+ * State of the board at a given ply. The hash is the hash of the position at that ply, while the board state and move
+ * are filled in when a move is made from that position, and are used to undo it.
  */
-class Board
+struct UndoState
 {
-  public:
-    std::array<Bitboard, 14> bitboards{};
-    void loadFen(const std::string &fen);
-    std::string getFen() const;
-    void makeMove(Move move);
-    void makeMove(const std::string &uciMove);
-    void unmakeMove();
-    MoveList getLegalMoves();
-    MoveList getLegalCaptures();
-    std::string toString() const;
-    std::string uciMoveHistory() const;
-    Bitboard getSlidingPieces(PieceColor side) const;
-    bool isDraw();
-
-    PieceColor sideToMove = PieceColor::WHITE;
+    BoardState boardState;
+    Move move;
+    // Piece captured by the move, which is put back when the move is unmade
+    Piece capturedPiece;
+    uint64_t hash;
+    // Check info of the position before the move, so that it doesn't need to be recomputed when unmaking the move
+    CheckInfo checkInfo;
+    // Plies since the last null move before this position, or since the start of the history if there is none.
+    // Positions before a null move can't be repeated after it, so repetition detection doesn't look further back.
+    uint16_t pliesSinceNullMove;
+};
 
-    Bitboard getPieces(PieceColor color) const
+/**
+ * Fixed capacity stack of undo states indexed by ply, which never allocates when moves are made or unmade. The entry
+ * at the current ply is always present, so top() can be used to get the state of the current position.
+ */
+class UndoStack
+{
+  public:
+    UndoStack()
     {
-
-        using enum PieceKind;
-        using enum PieceColor;
-        return color == WHITE
-                   ? bitboards[Piece{PAWN, WHITE}.index()] |
-                         bitboards[Piece{KNIGHT, WHITE}.index()] |
-                         bitboards[Piece{BISHOP, WHITE}.index()] |
-                         bitboards[Piece{ROOK, WHITE}.index()] |
-                         bitboards[Piece{QUEEN, WHITE}.index()] |
-                         bitboards[Piece{KING, WHITE}.index()]
-                   : bitboards[Piece{PAWN, BLACK}.index()] |
-                         bitboards[Piece{KNIGHT, BLACK}.index()] |
-                         bitboards[Piece{BISHOP, BLACK}.index()] |
-                         bitboards[Piece{ROOK, BLACK}.index()] |
-                         bitboards[Piece{QUEEN, BLACK}.index()] |
-                         bitboards[Piece{KING, BLACK}.index()];
+        entries[0].state = UndoState{};
     }
 
-    Bitboard getPieces() const
+    UndoStack(const UndoStack &other)
     {
-        return getPieces(PieceColor::WHITE) | getPieces(PieceColor::BLACK);
+        *this = other;
     }
 
-    bool isSideInCheck(PieceColor side) const
+    UndoStack &operator=(const UndoStack &other)
     {
-        const Bitboard kingBitboard = side == PieceColor::WHITE
-                                          ? bitboards[Piece{PieceKind::KING, PieceColor::WHITE}.index()]
-                                          : bitboards[Piece{PieceKind::KING, PieceColor::BLACK}.index()];
-        const Bitboard squaresAttackedBySide = getAttackingSquares(oppositeColor(side));
-        return (squaresAttackedBySide & kingBitboard) != 0;
+        // Only copy the plies that have been played rather than the whole array
+        currentPly = other.currentPly;
+        std::copy_n(other.entries.begin(), currentPly + 1, entries.begin());
+        return *this;
     }
 
-    bool isCheck() const
+    UndoState &top()
     {
-        return isSideInCheck(PieceColor::WHITE) || isSideInCheck(PieceColor::BLACK);
+        return entries[currentPly].state;
     }
 
-    bool isCheckmate(PieceColor side)
+    const UndoState &top() const
     {
-        return sideToMove == side && isSideInCheck(side) && getLegalMoves().empty();
+        return entries[currentPly].state;
     }
 
-    Piece operator[](Square index) const
+    UndoState &push()
     {
-        return board[index];
+        if (currentPly + 1 >= MAX_GAME_LENGTH)
+            [[unlikely]]
+        {
+            throw std::runtime_error{"Maximum game length exceeded"};
+        }
+        return entries[++currentPly].state;
     }
 
-    int8_t getEnPassantTargetSquare() const
+    void pop()
     {
-        return enPassantTargetSquare;
+        currentPly--;
     }
 
-    Bitboard getAttackingSquares(PieceColor side) const
+    void clear()
     {
-        return side == PieceColor::WHITE ? whiteAttackingSquares : blackAttackingSquares;
+        currentPly = 0;
     }
 
-    bool isSquareEmpty(Square square) const
+    const UndoState &operator[](size_t ply) const
     {
-        return board[square].isNone();
+        return entries[ply].state;
     }
 
-    bool canWhiteShortCastle() const
+    /**
+     * Number of moves that have been made, which is also the index of the current position
+     */
+    size_t ply() const
     {
-        return whiteCanShortCastle;
+        return currentPly;
     }
 
-    bool canWhiteLongCastle() const
+  private:
+    /**
+     * Holds an undo state without constructing it, so that creating or copying a stack doesn't write all of its
+     * entries. Only the entry at ply 0 is initialised, and every other entry is written when its ply is reached before
+     * it is read.
+     */
+    union Entry
+    {
+        // Entries are copied as raw bytes by the union's copy assignment
+        static_assert(std::is_trivially_copyable_v<UndoState>);
+        UndoState state;
+
+        Entry()
+        {
+        }
+    };
+
+    alignas(64) std::array<Entry, MAX_GAME_LENGTH> entries;
+    size_t currentPly = 0;
+};
+
+/**
+ * Represents a full game (including previous states), including piece positions, side to move, castling rights, etc
+ */
+class Board : public Position
+{
+  public:
+    void loadFen(std::string_view fen);
+    /**
+     * Sets up the board from a position, with no previous moves
+     */
+    void loadPosition(const Position &position);
+    std::string getFen() const;
+    void makeMove(Move move);
+    /**
+     * Makes a move for Side, which must be the side to move, without dispatching on the side at runtime
+     */
+    template <PieceColor Side>
+    void makeMove(Move move);
+    void makeMove(const std::string &uciMove);
+    void unmakeMove();
+
+    /**
+     * Makes a null move (see Position::makeNullMove()) and stores the state needed to unmake it
+     */
+    void makeNullMove();
+    void unmakeNullMove();
+    std::string toString() const;
+    std::string uciMoveHistory() const;
+    bool isDraw() const;
+
+    /**
+     * Same as Position::terminalStatus(), but also checks for threefold repetition
+     */
+    TerminalStatus terminalStatus(const MoveList &legalMoves) const;
+
+    TerminalStatus terminalStatus() const
     {
-        return whiteCanLongCastle;
+        return terminalStatus(getLegalMoves());
     }
 
-    bool canBlackShortCastle() const
+    Piece operator[](Square index) const
     {
-        return blackCanShortCastle;
+        return board[index];
     }
 
-    bool canBlackLongCastle() const
+    bool isSquareEmpty(Square square) const
     {
-        return blackCanLongCastle;
+        return board[square].isNone();
     }
 
-    uint64_t getHash() const
+    std::vector<Move> getMoveHistory() const
     {
-        return hashHistory.top();
+        std::vector<Move> moves;
+        moves.reserve(history.ply());
+        for (size_t i = 0; i < history.ply(); i++)
+        {
+            moves.push_back(history[i].move);
+        }
+        return moves;
     }
 
-    std::vector<Move> getMoveHistory()
+    /**
+     * Hashes of the positions reached so far, which can be used to detect repetitions when continuing the game with
+     * copy-make on a Position
+     */
+    PositionHistory getPositionHistory() const
     {
-        return moveHistory;
+        PositionHistory positionHistory;
+        for (size_t i = 0; i <= history.ply(); i++)
+        {
+            positionHistory.push(history[i].hash);
+        }
+        return positionHistory;
     }
 
-    bool isStalemate();
-    bool isInsufficientMaterial() const;
     bool isThreefoldRepetition() const;
-    bool isDrawByFiftyMoveRule() const;
+
+    /**
+     * Repetition detection for search, where a position that has occurred once before since the root of the search
+     * (searchRootPly) is treated as a draw, since the side that can force the repetition can repeat it again. Positions
+     * before the root still need to occur three times.
+     */
+    bool isRepetitionInSearch(size_t searchRootPly) const;
+
+    /**
+     * Number of moves that have been made since the position was loaded
+     */
+    size_t getPly() const
+    {
+        return history.ply();
+    }
 
   private:
     std::array<Piece, 64> board{}; // TODO: Can be removed?
 
-    Bitboard whiteAttackingSquares = 0;
-    Bitboard blackAttackingSquares = 0;
-
-    int8_t enPassantTargetSquare = -1;
+    UndoStack history;
 
-    bool whiteCanShortCastle = false;
-    bool whiteCanLongCastle = false;
-    bool blackCanShortCastle = false;
-    bool blackCanLongCastle = false;
-
-    uint8_t halfMoveClock = 0;
-
-    std::vector<Move> moveHistory;
-    std::stack<uint64_t> hashHistory;
-    std::stack<BoardState> boardHistory;
-
-    uint64_t hash() const;
-    uint64_t hashAfterMove(Move move, Piece movingPiece, Piece capturedPiece, uint64_t currentHash) const;
-
-    void movePiece(Piece piece, Piece capturedPiece, Square start, Square end);
-    void addPiece(Piece piece, Square position);
-    void addPiece(MoveFlag promotedPiece, PieceColor side, Square position);
-    void removePiece(Piece piece, Square position);
-    void removePiece(MoveFlag promotedPiece, PieceColor side, Square position);
-    void updateAttackingSquares();
+    /**
+     * Number of plies back that a repetition of the current position can be, which is limited by both the last
+     * irreversible move and the last null move
+     */
+    int64_t repetitionWindow() const
+    {
+        return std::min<int64_t>(halfMoveClock, history.top().pliesSinceNullMove);
+    }
 };
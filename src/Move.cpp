@@ -1,13 +1,6 @@
 #include "Move.hpp"
 #include "Board.hpp"
 
-Move::Move(Square start, Square end, MoveFlag flag)
-{
-    moveData |= start << 10;
-    moveData |= end << 4;
-    moveData |= static_cast<uint8_t>(flag);
-}
-
 Move::Move(const Board &board, const std::string &uciString)
 {
     if (uciString.length() != 4 && uciString.length() != 5)
@@ -78,24 +71,8 @@ Move::Move(const Board &board, const std::string &uciString)
     moveData |= static_cast<uint8_t>(moveFlag);
 }
 
-uint8_t Move::start() const
-{
-    return (moveData & 0b1111110000000000) >> 10;
-}
-
-uint8_t Move::end() const
-{
-    return (moveData & 0b0000001111110000) >> 4;
-}
-
-MoveFlag Move::moveFlag() const
-{
-    return static_cast<MoveFlag>(moveData & 0b0000000000001111);
-}
-
-std::string Move::getPgn(Board boardBeforeMove) const
+std::string Move::getPgn(const Board &board) const
 {
-    Board board = boardBeforeMove;
     std::string moveString;
 
     Piece movedPiece = board[start()];
@@ -211,13 +188,14 @@ std::string Move::getPgn(Board boardBeforeMove) const
             break;
         }
     }
-    // Test for check and checkmate, so we need to actually make the move
-    board.makeMove(*this); // Board is copied so this is fine
-    if (board.isCheckmate(PieceColor::WHITE) || board.isCheckmate(PieceColor::BLACK))
+    // Test for check and checkmate, so we need to actually make the move (on a copy of the position)
+    Position positionAfterMove = board;
+    positionAfterMove.makeMove(*this);
+    if (positionAfterMove.terminalStatus() == TerminalStatus::CHECKMATE)
     {
         moveString.append("#");
     }
-    else if (board.isCheck())
+    else if (positionAfterMove.isCheck())
     {
         // Comment from old code, not sure if this is still relevant
         // Probably not, since this was when the PGN was generated for the whole game at once, but we'll see
@@ -7,19 +7,36 @@
 
 class Board;
 
+/**
+ * A move packed into 16 bits. Anything else needed about a move, such as its ordering score or the piece it captured,
+ * is stored next to the move where it is needed, so that move lists stay small.
+ */
 class Move
 {
   public:
-    Move(Square start, Square end, MoveFlag flag);
+    constexpr Move(Square start, Square end, MoveFlag flag)
+        : moveData(static_cast<uint16_t>(start << 10 | end << 4 | static_cast<uint8_t>(flag)))
+    {
+    }
     Move(const Board &board, const std::string &uciString);
     Move() = default;
-    Square start() const;
-    Square end() const;
-    MoveFlag moveFlag() const;
-    std::string getPgn(Board boardBeforeMove) const;
-    int score = 0;
 
-    Piece capturedPiece;
+    constexpr Square start() const
+    {
+        return (moveData & 0b1111110000000000) >> 10;
+    }
+
+    constexpr Square end() const
+    {
+        return (moveData & 0b0000001111110000) >> 4;
+    }
+
+    constexpr MoveFlag moveFlag() const
+    {
+        return static_cast<MoveFlag>(moveData & 0b0000000000001111);
+    }
+
+    std::string getPgn(const Board &board) const;
 
     bool isPromotion() const
     {
@@ -45,3 +62,5 @@ class Move
     // 6 bits - end index
     // 4 bits - flag
 };
+
+static_assert(sizeof(Move) == 2);
@@ -2,9 +2,24 @@
 
 #include "Move.hpp"
 #include <array>
+#include <cstddef>
 
-struct MoveList
+// Maximum number of legal moves in any position
+constexpr size_t MAX_MOVES = 218;
+// Maximum number of captures and promotions in any position. Pieces other than pawns that can promote have at most eight
+// captures each (one per direction), including en passant. A pawn that can promote has at most three promotion squares
+// and each square of the last rank can be promoted to by at most two pawns, with four moves per promotion, so p pawns
+// that can promote have at most min(12p, 64) moves. The total of min(12p, 64) + 8 * (16 - p) is largest with p = 5.
+constexpr size_t MAX_CAPTURES = 148;
+
+/**
+ * Fixed capacity list of moves which never allocates. Lists that only hold captures and promotions can use a smaller
+ * capacity, and lists can be kept for each ply and reused instead of being created for every position.
+ */
+template <size_t Capacity>
+class BasicMoveList
 {
+  public:
     void push_back(Move move)
     {
         moves[count++] = move;
@@ -15,6 +30,11 @@ struct MoveList
         moves[count++] = Move{start, end, moveFlag};
     }
 
+    void clear()
+    {
+        count = 0;
+    }
+
     Move operator[](size_t i) const
     {
         return moves[i];
@@ -27,12 +47,22 @@ struct MoveList
 
     Move *begin()
     {
-        return &moves[0];
+        return moves.data();
     }
 
     Move *end()
     {
-        return &moves[count];
+        return moves.data() + count;
+    }
+
+    const Move *begin() const
+    {
+        return moves.data();
+    }
+
+    const Move *end() const
+    {
+        return moves.data() + count;
     }
 
     size_t size() const
@@ -40,12 +70,20 @@ struct MoveList
         return count;
     }
 
+    static constexpr size_t capacity()
+    {
+        return Capacity;
+    }
+
     Move last() const
     {
         return moves[count - 1];
     }
 
-private:
-    std::array<Move, 218> moves;
+  private:
+    std::array<Move, Capacity> moves;
     uint8_t count = 0;
-};
\ No newline at end of file
+};
+
+using MoveList = BasicMoveList<MAX_MOVES>;
+using CaptureList = BasicMoveList<MAX_CAPTURES>;
@@ -0,0 +1,215 @@
+#include "MovePicker.hpp"
+#include "Board.hpp"
+#include "eval.hpp"
+#include "movegen.hpp"
+#include <algorithm>
+
+// Bonus used when ordering moves that give check
+constexpr int CHECK_MOVE_SCORE = 50;
+// Subtracted from the score of captures that lose material, so that they are tried after every other capture
+constexpr int LOSING_CAPTURE_PENALTY = 1 << 20;
+// Below this much material on the board, quiet moves are ordered by how much they improve the endgame evaluation
+constexpr int ENDGAME_MATERIAL = 1200;
+
+int endgameMoveScore(Board &board, const Move &move)
+{
+    int s = 0;
+    board.makeMove(move);
+    s = endgameEval(board) * (board.sideToMove == PieceColor::BLACK ? -1 : 1);
+    board.unmakeMove();
+    return s;
+}
+
+/**
+ * Generates the moves of a stage, which are pseudo-legal if the search is built to generate pseudo-legal moves
+ */
+template <size_t Capacity>
+void generateStageMoves(const Board &board, BasicMoveList<Capacity> &moves, movegen::GenerationMode mode)
+{
+    if constexpr (movegen::SEARCH_MOVE_LEGALITY == movegen::MoveLegality::PSEUDO_LEGAL)
+    {
+        movegen::generatePseudoLegalMoves(board, moves, mode);
+    }
+    else
+    {
+        movegen::generateLegalMoves(board, moves, mode);
+    }
+}
+
+template <size_t Capacity>
+MovePicker<Capacity>::MovePicker(Board &board, BasicMoveList<Capacity> &moves, Move ttMove,
+                                 const std::array<Move, 2> &killers)
+    requires(Capacity == MAX_MOVES)
+    : board(board), stage(Stage::TT_MOVE), capturesOnly(false), ttMove(ttMove), killers(killers), moves(moves)
+{
+    moves.clear();
+}
+
+template <size_t Capacity>
+MovePicker<Capacity>::MovePicker(Board &board, BasicMoveList<Capacity> &moves)
+    : board(board), stage(Stage::GENERATE_CAPTURES), capturesOnly(true), moves(moves)
+{
+    moves.clear();
+}
+
+bool isQuiet(const Board &board, Move move)
+{
+    return board[move.end()].isNone() && move.moveFlag() != MoveFlag::EnPassant && !move.isPromotion();
+}
+
+template <size_t Capacity>
+Move MovePicker<Capacity>::next()
+{
+    switch (stage)
+    {
+    case Stage::TT_MOVE:
+        stage = Stage::GENERATE_CAPTURES;
+        // The TT move is usually the best move, so it is tried before generating anything
+        if (board.isPseudoLegal(ttMove) && board.isLegal(ttMove))
+        {
+            return ttMove;
+        }
+        ttMove = Move{};
+        [[fallthrough]];
+
+    case Stage::GENERATE_CAPTURES:
+    {
+        if (!capturesOnly && board.isSideInCheck(board.sideToMove))
+        {
+            // There are few legal moves in check, so they are all generated at once and split into the two stages
+            movegen::generateLegalMoves(board, moves, movegen::GenerationMode::EVASIONS);
+            const Move *noisyEnd = std::partition(moves.begin(), moves.end(), [this](Move move)
+                                                  { return !isQuiet(board, move); });
+            capturesEnd = noisyEnd - moves.begin();
+            quietsGenerated = true;
+            movesAreLegal = true;
+        }
+        else
+        {
+            generateStageMoves(board, moves, movegen::GenerationMode::CAPTURES);
+            capturesEnd = moves.size();
+        }
+        scoreCaptures();
+        stage = Stage::CAPTURES;
+        [[fallthrough]];
+    }
+
+    case Stage::CAPTURES:
+        while (current < capturesEnd)
+        {
+            const Move move = selectBest(capturesEnd);
+            // Losing captures are ordered last, so the quiescence search can skip the rest of the stage
+            if (capturesOnly && scores[current - 1] < 0)
+            {
+                break;
+            }
+            if (move != ttMove && isLegal(move))
+            {
+                return move;
+            }
+        }
+        if (capturesOnly)
+        {
+            stage = Stage::DONE;
+            return Move{};
+        }
+        stage = Stage::KILLERS;
+        [[fallthrough]];
+
+    case Stage::KILLERS:
+        while (killerIndex < killers.size())
+        {
+            const Move killer = killers[killerIndex++];
+            if (killer != ttMove && board.isPseudoLegal(killer) && isQuiet(board, killer) && board.isLegal(killer))
+            {
+                return killer;
+            }
+        }
+        stage = Stage::GENERATE_QUIETS;
+        [[fallthrough]];
+
+    case Stage::GENERATE_QUIETS:
+        if (!quietsGenerated)
+        {
+            generateStageMoves(board, moves, movegen::GenerationMode::QUIETS);
+        }
+        scoreQuiets();
+        stage = Stage::QUIETS;
+        [[fallthrough]];
+
+    case Stage::QUIETS:
+        while (current < moves.size())
+        {
+            const Move move = selectBest(moves.size());
+            if (!isAlreadyPickedQuiet(move) && isLegal(move))
+            {
+                return move;
+            }
+        }
+        stage = Stage::DONE;
+        [[fallthrough]];
+
+    case Stage::DONE:
+        return Move{};
+    }
+    return Move{};
+}
+
+template <size_t Capacity>
+bool MovePicker<Capacity>::isLegal(Move move) const
+{
+    return movesAreLegal || board.isLegal(move);
+}
+
+template <size_t Capacity>
+void MovePicker<Capacity>::scoreCaptures()
+{
+    for (size_t i = 0; i < capturesEnd; i++)
+    {
+        const Move move = moves[i];
+        const PieceKind victim = move.moveFlag() == MoveFlag::EnPassant ? PieceKind::PAWN : board[move.end()].kind();
+        const PieceKind attacker = board[move.start()].kind();
+        // Most valuable victim first, then least valuable attacker. The victim is weighted so that the attacker only
+        // breaks ties between captures of the same piece.
+        scores[i] = pieceValue(victim) * 16 - pieceValue(attacker);
+        if (move.isPromotion())
+        {
+            scores[i] += pieceValue(Piece{move.moveFlag(), board.sideToMove}.kind()) * 16;
+        }
+        // Taking a piece worth at least the attacker can't lose material, so the exchange is only evaluated otherwise
+        if ((pieceValue(attacker) > pieceValue(victim) || move.isPromotion()) && board.see(move) < 0)
+        {
+            scores[i] -= LOSING_CAPTURE_PENALTY;
+        }
+    }
+}
+
+template <size_t Capacity>
+void MovePicker<Capacity>::scoreQuiets()
+{
+    const bool isEndgame = whiteMaterial(board) + blackMaterial(board) < ENDGAME_MATERIAL;
+    for (size_t i = capturesEnd; i < moves.size(); i++)
+    {
+        if (isEndgame)
+        {
+            scores[i] = endgameMoveScore(board, moves[i]);
+        }
+        else
+        {
+            // Checks are likely to be good moves
+            scores[i] = board.givesCheck(moves[i]) ? CHECK_MOVE_SCORE : 0;
+        }
+    }
+}
+
+template <size_t Capacity>
+Move MovePicker<Capacity>::selectBest(size_t end)
+{
+    const size_t best = std::max_element(scores.begin() + current, scores.begin() + end) - scores.begin();
+    std::swap(moves.begin()[current], moves.begin()[best]);
+    std::swap(scores[current], scores[best]);
+    return moves[current++];
+}
+
+template class MovePicker<MAX_MOVES>;
+template class MovePicker<MAX_CAPTURES>;
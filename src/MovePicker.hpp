@@ -0,0 +1,101 @@
+#pragma once
+
+#include "Move.hpp"
+#include "MoveList.hpp"
+#include "movegen.hpp"
+#include <array>
+#include <cstdint>
+
+class Board;
+
+/**
+ * Returns the moves of a position one at a time, most promising first, so that a node which is cut off early doesn't
+ * pay for scoring and sorting moves that are never searched. Moves are produced in stages: the transposition table move
+ * (before any moves are generated), captures and promotions ordered by MVV-LVA with the ones that lose material by
+ * static exchange evaluation last, killer moves, and then the remaining quiet moves. The quiescence search picker skips
+ * the losing captures. Each stage is only scored when it is reached, and the best remaining move of a stage is
+ * selected every time next() is called instead of sorting the whole stage up front.
+ *
+ * Moves are generated into a list owned by the caller, usually one per ply that is reused for every node at that ply,
+ * and their scores are kept in a separate array because nothing else needs them. A picker that only picks captures can
+ * use a CaptureList.
+ *
+ * When the search is built with pseudo-legal generation, the legality of each move is only checked when it is about to
+ * be returned, so the moves after a cutoff are never checked.
+ */
+template <size_t Capacity>
+class MovePicker
+{
+  public:
+    /**
+     * Picks every legal move, for the main search. The TT move and killers don't need to be legal in this position,
+     * because they are checked before being returned.
+     */
+    MovePicker(Board &board, BasicMoveList<Capacity> &moves, Move ttMove, const std::array<Move, 2> &killers)
+        requires(Capacity == MAX_MOVES);
+
+    /**
+     * Picks only captures and promotions that don't lose material, for the quiescence search
+     */
+    MovePicker(Board &board, BasicMoveList<Capacity> &moves);
+
+    /**
+     * Returns the next move to search, or an invalid move once every move has been returned
+     */
+    Move next();
+
+  private:
+    enum class Stage : uint8_t
+    {
+        TT_MOVE,
+        GENERATE_CAPTURES,
+        CAPTURES,
+        KILLERS,
+        GENERATE_QUIETS,
+        QUIETS,
+        DONE
+    };
+
+    Board &board;
+    Stage stage;
+    bool capturesOnly;
+    Move ttMove;
+    std::array<Move, 2> killers{};
+    uint8_t killerIndex = 0;
+
+    // Captures and promotions come before the quiet moves, which are only generated once the killers have been tried
+    BasicMoveList<Capacity> &moves;
+    // Ordering scores of the moves at the same indices
+    std::array<int, Capacity> scores;
+    size_t capturesEnd = 0;
+    // Evasions are generated all at once, so the quiet moves may already be in the list
+    bool quietsGenerated = false;
+    // Evasions are always generated legally, while other moves may be pseudo-legal depending on the build
+    bool movesAreLegal = movegen::SEARCH_MOVE_LEGALITY == movegen::MoveLegality::LEGAL;
+    // Moves before this index have already been returned
+    size_t current = 0;
+
+    void scoreCaptures();
+    void scoreQuiets();
+
+    /**
+     * Moves the highest scoring move between current and end (and its score) to current and returns it
+     */
+    Move selectBest(size_t end);
+
+    bool isLegal(Move move) const;
+
+    /**
+     * Whether a quiet move was already returned by the TT move or killer stages. A killer that is a capture in this
+     * position is never returned by the killer stage, so this is only valid for quiet moves.
+     */
+    bool isAlreadyPickedQuiet(Move move) const
+    {
+        return move == ttMove || move == killers[0] || move == killers[1];
+    }
+};
+
+/**
+ * Whether a move is neither a capture nor a promotion, which is what killer moves are restricted to
+ */
+bool isQuiet(const Board &board, Move move);
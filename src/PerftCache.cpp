@@ -0,0 +1,59 @@
+#include "PerftCache.hpp"
+#include <algorithm>
+
+// Counts are stored above the depth, so larger counts can't be cached
+constexpr size_t MAX_CACHED_COUNT = (static_cast<size_t>(1) << 56) - 1;
+
+PerftCache::PerftCache(size_t sizeMB)
+    : bucketCount(std::max<size_t>(sizeMB * 1024 * 1024 / sizeof(Bucket), 1)),
+      buckets(std::make_unique<Bucket[]>(bucketCount))
+{
+}
+
+std::optional<size_t> PerftCache::probe(uint64_t hash, uint8_t depth)
+{
+    Bucket &b = bucket(hash);
+    for (const Entry *entry : {&b.deepest, &b.latest})
+    {
+        const uint64_t data = entry->data.load(std::memory_order_relaxed);
+        if ((entry->check.load(std::memory_order_relaxed) ^ data) == hash && (data & 0xFF) == depth)
+        {
+            return data >> 8;
+        }
+    }
+    return std::nullopt;
+}
+
+void PerftCache::store(uint64_t hash, uint8_t depth, size_t positionsReached)
+{
+    if (positionsReached > MAX_CACHED_COUNT)
+    {
+        return;
+    }
+    const uint64_t data = static_cast<uint64_t>(positionsReached) << 8 | depth;
+    Bucket &b = bucket(hash);
+    // The depth may be read from an entry that another thread is writing, which only affects which entry is replaced
+    Entry &entry = (b.deepest.data.load(std::memory_order_relaxed) & 0xFF) <= depth ? b.deepest : b.latest;
+    entry.check.store(hash ^ data, std::memory_order_relaxed);
+    entry.data.store(data, std::memory_order_relaxed);
+}
+
+void PerftCache::addProbes(size_t probes, size_t hits)
+{
+    probeCount.fetch_add(probes, std::memory_order_relaxed);
+    hitCount.fetch_add(hits, std::memory_order_relaxed);
+}
+
+void PerftCache::clear()
+{
+    for (size_t i = 0; i < bucketCount; i++)
+    {
+        for (Entry *entry : {&buckets[i].deepest, &buckets[i].latest})
+        {
+            entry->check.store(0, std::memory_order_relaxed);
+            entry->data.store(0, std::memory_order_relaxed);
+        }
+    }
+    probeCount = 0;
+    hitCount = 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+/**
+ * Perft counts of positions that have already been counted, keyed by the position's hash and the remaining depth, so
+ * that transpositions in the perft tree are only counted once. The cache can be shared by threads without locks: each
+ * entry is two atomic words, the key XOR the data and the data, so an entry that is torn by two threads writing it at
+ * once fails the key check and is treated as a miss instead of returning a wrong count.
+ *
+ * Each bucket has one entry that is only replaced by counts of the same or a greater depth, which are the most
+ * expensive to recount, and one entry that is always replaced.
+ */
+class PerftCache
+{
+  public:
+    explicit PerftCache(size_t sizeMB);
+
+    /**
+     * Returns the number of positions reached from the position with this hash at this depth, if it is cached
+     */
+    std::optional<size_t> probe(uint64_t hash, uint8_t depth);
+
+    void store(uint64_t hash, uint8_t depth, size_t positionsReached);
+
+    /**
+     * Adds probes and hits to the totals. probe() doesn't count them itself, because every thread writing to the same
+     * counters on every probe would make them the most contended part of the cache, so each thread counts its own and
+     * adds them when it is done.
+     */
+    void addProbes(size_t probes, size_t hits);
+
+    void clear();
+
+    size_t probes() const
+    {
+        return probeCount.load(std::memory_order_relaxed);
+    }
+
+    size_t hits() const
+    {
+        return hitCount.load(std::memory_order_relaxed);
+    }
+
+    double hitRate() const
+    {
+        return probes() == 0 ? 0.0 : static_cast<double>(hits()) / static_cast<double>(probes());
+    }
+
+  private:
+    struct Entry
+    {
+        std::atomic<uint64_t> check;
+        // Count in the upper 56 bits and depth in the lower 8 bits
+        std::atomic<uint64_t> data;
+    };
+
+    struct alignas(32) Bucket
+    {
+        Entry deepest;
+        Entry latest;
+    };
+
+    size_t bucketCount;
+    std::unique_ptr<Bucket[]> buckets;
+    std::atomic<size_t> probeCount = 0;
+    std::atomic<size_t> hitCount = 0;
+
+    Bucket &bucket(uint64_t hash)
+    {
+        return buckets[hash % bucketCount];
+    }
+};
@@ -22,32 +22,32 @@ enum class PieceColor : uint8_t
     BLACK = 0b00001000
 };
 
-inline PieceColor oppositeColor(PieceColor color)
+constexpr PieceColor oppositeColor(PieceColor color)
 {
     return static_cast<PieceColor>(static_cast<uint8_t>(color) ^ 0b00001000);
 }
 
 struct Piece
 {
-    Piece(PieceKind kind, PieceColor color)
+    constexpr Piece(PieceKind kind, PieceColor color)
         : data(static_cast<uint8_t>(kind) | static_cast<uint8_t>(color))
     {
     }
 
-    Piece() = default;
+    constexpr Piece() = default;
 
     // TODO: Cannot use kind() == NONE because of 0xFF definition
-    PieceKind kind() const
+    constexpr PieceKind kind() const
     {
         return static_cast<PieceKind>(data & 0b00000111);
     }
 
-    PieceColor color() const
+    constexpr PieceColor color() const
     {
         return static_cast<PieceColor>(data & 0b00001000);
     }
 
-    bool isNone() const
+    constexpr bool isNone() const
     {
         return data == 0xFF;
     }
@@ -136,7 +136,7 @@ struct Piece
         }
     }
 
-    uint8_t index() const
+    constexpr uint8_t index() const
     {
         return data;
     }
@@ -0,0 +1,970 @@
+#include "Position.hpp"
+#include "eval.hpp"
+#include "movegen.hpp"
+#include <algorithm>
+#include <charconv>
+
+using enum PieceKind;
+using enum PieceColor;
+
+/**
+ * Returns the next whitespace separated field in the text and removes it from the text
+ */
+std::string_view nextField(std::string_view &text)
+{
+    const size_t start = std::min(text.find_first_not_of(" \t\r\n"), text.size());
+    const size_t end = std::min(text.find_first_of(" \t\r\n", start), text.size());
+    const std::string_view field = text.substr(start, end - start);
+    text.remove_prefix(end);
+    return field;
+}
+
+void Position::loadFen(std::string_view fen)
+{
+    std::string_view remainingFields = parsePositionFields(fen);
+
+    const std::string_view halfMoveClockField = nextField(remainingFields);
+    if (!halfMoveClockField.empty())
+    {
+        unsigned int value = 0;
+        const auto [end, error] = std::from_chars(halfMoveClockField.data(),
+                                                  halfMoveClockField.data() + halfMoveClockField.size(), value);
+        if (error != std::errc{} || end != halfMoveClockField.data() + halfMoveClockField.size() || value > 255)
+        {
+            throw std::invalid_argument{"Invalid FEN"};
+        }
+        halfMoveClock = static_cast<uint8_t>(value);
+    }
+
+    // The fullmove number isn't stored, but it must still be a number and nothing may follow it
+    const std::string_view fullMoveNumberField = nextField(remainingFields);
+    if (!fullMoveNumberField.empty())
+    {
+        unsigned int value = 0;
+        const auto [end, error] = std::from_chars(fullMoveNumberField.data(),
+                                                  fullMoveNumberField.data() + fullMoveNumberField.size(), value);
+        if (error != std::errc{} || end != fullMoveNumberField.data() + fullMoveNumberField.size())
+        {
+            throw std::invalid_argument{"Invalid FEN"};
+        }
+    }
+    if (!nextField(remainingFields).empty())
+    {
+        throw std::invalid_argument{"Invalid FEN"};
+    }
+}
+
+std::string_view Position::loadEpd(std::string_view epd)
+{
+    std::string_view operations = parsePositionFields(epd);
+    const size_t start = operations.find_first_not_of(" \t");
+    return start == std::string_view::npos ? std::string_view{} : operations.substr(start);
+}
+
+std::string_view Position::parsePositionFields(std::string_view text)
+{
+    *this = Position{};
+
+    const std::string_view placement = nextField(text);
+    const std::string_view side = nextField(text);
+    const std::string_view castling = nextField(text);
+    const std::string_view enPassant = nextField(text);
+
+    int i = 0;
+    int rowsEnded = 0;
+    for (const char c : placement)
+    {
+        if (c == '/')
+        {
+            // Every row must be complete before the next one starts
+            rowsEnded++;
+            if (i != 8 * rowsEnded)
+            {
+                throw std::invalid_argument{"Invalid FEN"};
+            }
+        }
+        else if (c >= '1' && c <= '8')
+        {
+            i += c - '0';
+        }
+        else
+        {
+            const Piece piece{c};
+            if (piece.isNone() || i >= 64)
+            {
+                throw std::invalid_argument{"Invalid FEN"};
+            }
+            addPiece(piece, static_cast<Square>(i));
+            i++;
+        }
+        if (i > 64)
+        {
+            throw std::invalid_argument{"Invalid FEN"};
+        }
+    }
+    if (i != 64 || rowsEnded != 7 || getPieceCount(Piece{KING, WHITE}) == 0 || getPieceCount(Piece{KING, BLACK}) == 0)
+    {
+        throw std::invalid_argument{"Invalid FEN"};
+    }
+
+    if (side == "w")
+    {
+        sideToMove = WHITE;
+    }
+    else if (side == "b")
+    {
+        sideToMove = BLACK;
+    }
+    else
+    {
+        throw std::invalid_argument{"Invalid FEN"};
+    }
+
+    if (castling != "-")
+    {
+        if (castling.empty())
+        {
+            throw std::invalid_argument{"Invalid FEN"};
+        }
+        for (const char c : castling)
+        {
+            bool &right = c == 'K'   ? whiteCanShortCastle
+                          : c == 'Q' ? whiteCanLongCastle
+                          : c == 'k' ? blackCanShortCastle
+                                     : blackCanLongCastle;
+            if ((c != 'K' && c != 'Q' && c != 'k' && c != 'q') || right)
+            {
+                throw std::invalid_argument{"Invalid FEN"};
+            }
+            right = true;
+        }
+    }
+    // A right is meaningless once its king or rook has left its home square, and move generation assumes they are
+    // there, so drop it rather than trusting the FEN
+    const auto isOnSquare = [this](Piece piece, Square square) {
+        return (bitboards[piece.index()] & bitboards::withSquare(square)) != 0;
+    };
+    const bool whiteKingHome = isOnSquare(Piece{KING, WHITE}, 60);
+    const bool blackKingHome = isOnSquare(Piece{KING, BLACK}, 4);
+    whiteCanShortCastle = whiteCanShortCastle && whiteKingHome && isOnSquare(Piece{ROOK, WHITE}, 63);
+    whiteCanLongCastle = whiteCanLongCastle && whiteKingHome && isOnSquare(Piece{ROOK, WHITE}, 56);
+    blackCanShortCastle = blackCanShortCastle && blackKingHome && isOnSquare(Piece{ROOK, BLACK}, 7);
+    blackCanLongCastle = blackCanLongCastle && blackKingHome && isOnSquare(Piece{ROOK, BLACK}, 0);
+
+    // The en passant target is behind a pawn that has just moved two squares, so it's on the 6th rank when white is to
+    // move and the 3rd rank when black is
+    const char enPassantRank = sideToMove == WHITE ? '6' : '3';
+    if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' && enPassant[1] == enPassantRank)
+    {
+        enPassantTargetSquare = static_cast<int8_t>(8 * ('8' - enPassant[1]) + (enPassant[0] - 'a'));
+    }
+    else if (enPassant != "-")
+    {
+        throw std::invalid_argument{"Invalid FEN"};
+    }
+
+    positionHash = hash();
+    updateCheckInfo();
+    return text;
+}
+
+void Position::makeMove(Move move)
+{
+    if (sideToMove == WHITE)
+    {
+        makeMove<WHITE>(move);
+    }
+    else
+    {
+        makeMove<BLACK>(move);
+    }
+}
+
+template <PieceColor Side>
+void Position::makeMove(Move move)
+{
+    const Piece movedPiece = pieceAt(move.start());
+    const Piece capturedPiece = move.moveFlag() != MoveFlag::EnPassant
+                                    ? pieceAt(move.end())
+                                    : Piece{PAWN, oppositeColor(Side)};
+    applyMove<Side>(move, movedPiece, capturedPiece);
+}
+
+bool Position::isPseudoLegal(Move move) const
+{
+    if (move.isInvalid())
+    {
+        return false;
+    }
+
+    const Square start = move.start();
+    const Square end = move.end();
+    const MoveFlag flag = move.moveFlag();
+    const Piece piece = pieceAt(start);
+    const PieceColor side = sideToMove;
+
+    if (piece.isNone() || piece.color() != side || (getPieces(side) & bitboards::withSquare(end)) != 0)
+    {
+        return false;
+    }
+
+    if (piece.kind() == PAWN)
+    {
+        const int forward = side == WHITE ? -8 : 8;
+        const bool isOnStartingRank = side == WHITE ? start >= 48 && start < 56 : start >= 8 && start < 16;
+        const bool isOnPromotionRank = side == WHITE ? end < 8 : end >= 56;
+        const bool isDiagonal = (movegen::getPawnAttackingSquares(bitboards::withSquare(start), side) & bitboards::withSquare(end)) != 0;
+
+        if (flag == MoveFlag::EnPassant)
+        {
+            const Bitboard enemyPawns = bitboards[Piece{PAWN, oppositeColor(side)}.index()];
+            return isDiagonal && end == getEnPassantTargetSquare() &&
+                   (enemyPawns & bitboards::withSquare(end - forward)) != 0;
+        }
+        if (move.isPromotion() != isOnPromotionRank || flag == MoveFlag::ShortCastling || flag == MoveFlag::LongCastling)
+        {
+            return false;
+        }
+        if (isDiagonal)
+        {
+            return !isSquareEmpty(end);
+        }
+        if (end == start + forward)
+        {
+            return isSquareEmpty(end);
+        }
+        return isOnStartingRank && end == start + 2 * forward && isSquareEmpty(start + forward) && isSquareEmpty(end);
+    }
+
+    if (flag == MoveFlag::ShortCastling || flag == MoveFlag::LongCastling)
+    {
+        const Square kingStart = side == WHITE ? 60 : 4;
+        if (piece.kind() != KING || start != kingStart)
+        {
+            return false;
+        }
+        const Bitboard rooks = bitboards[Piece{ROOK, side}.index()];
+        if (flag == MoveFlag::ShortCastling)
+        {
+            const bool canCastle = side == WHITE ? whiteCanShortCastle : blackCanShortCastle;
+            return canCastle && end == start + 2 && (rooks & bitboards::withSquare(start + 3)) != 0 &&
+                   isSquareEmpty(start + 1) && isSquareEmpty(start + 2);
+        }
+        const bool canCastle = side == WHITE ? whiteCanLongCastle : blackCanLongCastle;
+        return canCastle && end == start - 2 && (rooks & bitboards::withSquare(start - 4)) != 0 &&
+               isSquareEmpty(start - 1) && isSquareEmpty(start - 2) && isSquareEmpty(start - 3);
+    }
+
+    if (flag != MoveFlag::None)
+    {
+        // Only pawns can promote or capture en passant
+        return false;
+    }
+
+    const Bitboard startBitboard = bitboards::withSquare(start);
+    Bitboard attackingSquares = 0;
+    switch (piece.kind())
+    {
+    case KNIGHT:
+        attackingSquares = movegen::getPieceAttackingSquares<KNIGHT>(getPieces(), startBitboard);
+        break;
+    case BISHOP:
+        attackingSquares = movegen::getPieceAttackingSquares<BISHOP>(getPieces(), startBitboard);
+        break;
+    case ROOK:
+        attackingSquares = movegen::getPieceAttackingSquares<ROOK>(getPieces(), startBitboard);
+        break;
+    case QUEEN:
+        attackingSquares = movegen::getPieceAttackingSquares<QUEEN>(getPieces(), startBitboard);
+        break;
+    case KING:
+        attackingSquares = movegen::getPieceAttackingSquares<KING>(getPieces(), startBitboard);
+        break;
+    default:
+        break;
+    }
+    return (attackingSquares & bitboards::withSquare(end)) != 0;
+}
+
+bool Position::isLegal(Move move) const
+{
+    const PieceColor side = sideToMove;
+    const PieceColor opponent = oppositeColor(side);
+    const Square start = move.start();
+    const Square end = move.end();
+
+    if (move.moveFlag() == MoveFlag::EnPassant)
+        [[unlikely]]
+    {
+        // En passant removes two pieces from the rank of the king, so it is simplest to make the move on a copy
+        Position positionAfterMove = *this;
+        positionAfterMove.makeMove(move);
+        return !positionAfterMove.isSideInCheck(side);
+    }
+    if (move.moveFlag() == MoveFlag::ShortCastling || move.moveFlag() == MoveFlag::LongCastling)
+    {
+        // The king can't castle out of, through or into check
+        const Square passedSquare = (start + end) / 2;
+        return !isSquareAttacked(start, opponent) && !isSquareAttacked(passedSquare, opponent) &&
+               !isSquareAttacked(end, opponent);
+    }
+    if (start == getKingSquare(side))
+    {
+        // The king can't hide behind itself from a sliding piece
+        return !isSquareAttacked(end, opponent, getPieces() & ~bitboards::withSquare(start));
+    }
+
+    // Most moves are decided by the check info alone. In check, a pinned piece can never capture or block the checker,
+    // and in double check only the king can move.
+    const Bitboard startBitboard = bitboards::withSquare(start);
+    const Bitboard endBitboard = bitboards::withSquare(end);
+    if (checkInfo.checkers != 0)
+    {
+        return (checkInfo.checkResolutions & endBitboard) != 0 && (checkInfo.pinned & startBitboard) == 0;
+    }
+    if ((checkInfo.pinned & startBitboard) == 0)
+    {
+        return true;
+    }
+
+    // A pinned piece is legal if it stays on the line of the pin. Any captured piece no longer attacks the king, and
+    // the moved piece may block an attack.
+    const Bitboard occupancyAfterMove = (getPieces() & ~startBitboard) | endBitboard;
+    return !isSquareAttacked(getKingSquare(side), opponent, occupancyAfterMove, endBitboard);
+}
+
+template <PieceColor Side>
+void Position::applyMove(Move move, Piece movedPiece, Piece capturedPiece)
+{
+    constexpr PieceColor opponent = oppositeColor(Side);
+    // The castling rights and en passant square are updated below, so their keys are removed from the hash first and
+    // the keys of the new ones are added back by hashAfterMove()
+    const uint64_t hashWithoutState = positionHash ^ castlingAndEnPassantKeys();
+
+    if (capturedPiece.isNone() && movedPiece.kind() != PAWN)
+    {
+        halfMoveClock++;
+    }
+    else
+    {
+        halfMoveClock = 0;
+    }
+
+    // The right to capture en passant has been lost because another move has been made
+    enPassantTargetSquare = -1;
+
+    if (movedPiece.kind() == PieceKind::PAWN)
+    {
+        // Set the en passant target square if a pawn moved 2 squares forward
+        constexpr int forward = Side == WHITE ? -8 : 8;
+        if (move.end() == move.start() + forward * 2)
+        {
+            enPassantTargetSquare = static_cast<int8_t>(move.start() + forward);
+        }
+    }
+
+    // Update king position and castling
+    if (movedPiece.kind() == PieceKind::KING)
+    {
+        // Castling
+        if (move.moveFlag() == MoveFlag::ShortCastling)
+        {
+            // Move rook
+            constexpr Square rookPosition = Side == WHITE ? 63 : 7;
+            movePiece(Piece{ROOK, Side}, Piece{}, rookPosition, move.end() - 1);
+        }
+        else if (move.moveFlag() == MoveFlag::LongCastling)
+        {
+            constexpr Square rookPosition = Side == WHITE ? 56 : 0;
+            movePiece(Piece{ROOK, Side}, Piece{}, rookPosition, move.end() + 1);
+        }
+
+        // King has moved so castling is no longer possible
+        if constexpr (Side == WHITE)
+        {
+            whiteCanShortCastle = false;
+            whiteCanLongCastle = false;
+        }
+        else
+        {
+            blackCanShortCastle = false;
+            blackCanLongCastle = false;
+        }
+    }
+
+    // Update castling rights if rook has moved
+    if (movedPiece.kind() == PieceKind::ROOK)
+    {
+        if constexpr (Side == WHITE)
+        {
+            if (move.start() == 56)
+            {
+                whiteCanLongCastle = false;
+            }
+            else if (move.start() == 63)
+            {
+                whiteCanShortCastle = false;
+            }
+        }
+        else
+        {
+            if (move.start() == 0)
+            {
+                blackCanLongCastle = false;
+            }
+            else if (move.start() == 7)
+            {
+                blackCanShortCastle = false;
+            }
+        }
+    }
+    // Rook was captured
+    if (capturedPiece.kind() == PieceKind::ROOK)
+    {
+        if constexpr (opponent == WHITE)
+        {
+            if (move.end() == 56)
+            {
+                whiteCanLongCastle = false;
+            }
+            else if (move.end() == 63)
+            {
+                whiteCanShortCastle = false;
+            }
+        }
+        else
+        {
+            if (move.end() == 0)
+            {
+                blackCanLongCastle = false;
+            }
+            else if (move.end() == 7)
+            {
+                blackCanShortCastle = false;
+            }
+        }
+    }
+
+    if (move.moveFlag() == MoveFlag::EnPassant)
+    {
+        // The captured pawn isn't on the destination square, so it is removed separately
+        removePiece(capturedPiece, Side == WHITE ? move.end() + 8 : move.end() - 8);
+        movePiece(movedPiece, Piece{}, move.start(), move.end());
+    }
+    else if (!move.isPromotion())
+        [[likely]]
+    {
+        movePiece(movedPiece, capturedPiece, move.start(), move.end());
+    }
+    else
+    {
+        removePiece(movedPiece, move.start());
+        // Remove captured piece before adding the promoted piece so that the destination stays occupied
+        if (!capturedPiece.isNone())
+        {
+            removePiece(capturedPiece, move.end());
+        }
+        addPiece(move.moveFlag(), Side, move.end());
+    }
+
+    sideToMove = opponent;
+
+    positionHash = hashAfterMove(move, movedPiece, capturedPiece, hashWithoutState);
+    checkInfo = movegen::computeCheckInfo<opponent>(*this);
+}
+
+template void Position::makeMove<WHITE>(Move move);
+template void Position::makeMove<BLACK>(Move move);
+template void Position::applyMove<WHITE>(Move move, Piece movedPiece, Piece capturedPiece);
+template void Position::applyMove<BLACK>(Move move, Piece movedPiece, Piece capturedPiece);
+
+void Position::updateCheckInfo()
+{
+    checkInfo = movegen::computeCheckInfo(*this);
+}
+
+MoveList Position::getLegalMoves() const
+{
+    return movegen::generateLegalMoves(*this);
+}
+
+template <PieceColor Side>
+MoveList Position::getLegalMoves() const
+{
+    return movegen::generateLegalMoves<Side>(*this);
+}
+
+template MoveList Position::getLegalMoves<WHITE>() const;
+template MoveList Position::getLegalMoves<BLACK>() const;
+
+size_t Position::countLegalMoves() const
+{
+    return movegen::countLegalMoves(*this);
+}
+
+template <PieceColor Side>
+size_t Position::countLegalMoves() const
+{
+    return movegen::countLegalMoves<Side>(*this);
+}
+
+template size_t Position::countLegalMoves<WHITE>() const;
+template size_t Position::countLegalMoves<BLACK>() const;
+
+bool Position::givesCheck(Move move) const
+{
+    return movegen::givesCheck(*this, move);
+}
+
+CaptureList Position::getLegalCaptures() const
+{
+    CaptureList captures;
+    movegen::generateLegalMoves(*this, captures, movegen::GenerationMode::CAPTURES);
+    return captures;
+}
+
+Piece Position::pieceAt(Square square) const
+{
+    const Bitboard squareBitboard = bitboards::withSquare(square);
+    for (const PieceColor color : {WHITE, BLACK})
+    {
+        for (const PieceKind kind : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING})
+        {
+            const Piece piece{kind, color};
+            if ((bitboards[piece.index()] & squareBitboard) != 0)
+            {
+                return piece;
+            }
+        }
+    }
+    return Piece{};
+}
+
+Bitboard Position::getSlidingPieces(PieceColor side) const
+{
+    return side == WHITE
+               ? bitboards[pieceIndexes::WHITE_BISHOP] | bitboards[pieceIndexes::WHITE_ROOK] | bitboards[pieceIndexes::WHITE_QUEEN]
+               : bitboards[pieceIndexes::BLACK_BISHOP] | bitboards[pieceIndexes::BLACK_ROOK] | bitboards[pieceIndexes::BLACK_QUEEN];
+}
+
+bool Position::isStalemate() const
+{
+    return terminalStatus() == TerminalStatus::STALEMATE;
+}
+
+bool Position::isInsufficientMaterial() const
+{
+    // TODO: Improve insufficient material detection (e.g. bishops of the same colour)
+    using namespace pieceIndexes;
+
+    const Bitboard majorPiecesAndPawns = bitboards[WHITE_PAWN] | bitboards[WHITE_ROOK] | bitboards[WHITE_QUEEN] |
+                                         bitboards[BLACK_PAWN] | bitboards[BLACK_ROOK] | bitboards[BLACK_QUEEN];
+    if (majorPiecesAndPawns != 0)
+    {
+        return false;
+    }
+
+    // A single knight or bishop can't checkmate, but two minor pieces can
+    const Bitboard whiteMinorPieces = bitboards[WHITE_KNIGHT] | bitboards[WHITE_BISHOP];
+    const Bitboard blackMinorPieces = bitboards[BLACK_KNIGHT] | bitboards[BLACK_BISHOP];
+    return std::popcount(whiteMinorPieces) <= 1 && std::popcount(blackMinorPieces) <= 1;
+}
+
+bool Position::isDrawByFiftyMoveRule() const
+{
+    // 50 moves by each side
+    return halfMoveClock >= 100;
+}
+
+bool Position::isDraw() const
+{
+    const TerminalStatus status = terminalStatus();
+    return status != TerminalStatus::NONE && status != TerminalStatus::CHECKMATE;
+}
+
+TerminalStatus Position::terminalStatus(const MoveList &legalMoves) const
+{
+    // Checkmate takes priority over the fifty move rule
+    if (legalMoves.empty())
+    {
+        return isSideInCheck(sideToMove) ? TerminalStatus::CHECKMATE : TerminalStatus::STALEMATE;
+    }
+    if (isDrawByFiftyMoveRule())
+    {
+        return TerminalStatus::FIFTY_MOVE_RULE;
+    }
+    if (isInsufficientMaterial())
+    {
+        return TerminalStatus::INSUFFICIENT_MATERIAL;
+    }
+    return TerminalStatus::NONE;
+}
+
+Bitboard Position::getAttackingSquares(PieceColor side, Bitboard occupancy) const
+{
+    return side == WHITE ? getAttackingSquares<WHITE>(occupancy) : getAttackingSquares<BLACK>(occupancy);
+}
+
+template <PieceColor Side>
+Bitboard Position::getAttackingSquares(Bitboard occupancy) const
+{
+    Bitboard attackingSquares = 0;
+
+    attackingSquares |= movegen::getPawnAttackingSquares<Side>(bitboards[Piece{PAWN, Side}.index()]);
+    attackingSquares |= movegen::getPieceAttackingSquares<KNIGHT>(occupancy, bitboards[Piece{KNIGHT, Side}.index()]);
+    attackingSquares |= movegen::getPieceAttackingSquares<BISHOP>(occupancy, bitboards[Piece{BISHOP, Side}.index()]);
+    attackingSquares |= movegen::getPieceAttackingSquares<ROOK>(occupancy, bitboards[Piece{ROOK, Side}.index()]);
+    attackingSquares |= movegen::getPieceAttackingSquares<QUEEN>(occupancy, bitboards[Piece{QUEEN, Side}.index()]);
+    attackingSquares |= movegen::getPieceAttackingSquares<KING>(occupancy, bitboards[Piece{KING, Side}.index()]);
+
+    return attackingSquares;
+}
+
+template Bitboard Position::getAttackingSquares<WHITE>(Bitboard occupancy) const;
+template Bitboard Position::getAttackingSquares<BLACK>(Bitboard occupancy) const;
+
+/**
+ * Checks whether a square is attacked by looking outwards from the square with each piece type and checking if an
+ * enemy piece of that type can be seen. This is much cheaper than computing the full attack map.
+ */
+bool Position::isSquareAttacked(Square square, PieceColor attacker, Bitboard occupancy, Bitboard removedPieces) const
+{
+    const Bitboard squareBitboard = bitboards::withSquare(square);
+    const Bitboard remainingPieces = ~removedPieces;
+    const Bitboard queens = bitboards[Piece{QUEEN, attacker}.index()];
+
+    if ((movegen::getPawnAttackingSquares(squareBitboard, oppositeColor(attacker)) & bitboards[Piece{PAWN, attacker}.index()] & remainingPieces) != 0)
+    {
+        return true;
+    }
+    if ((movegen::getPieceAttackingSquares<KNIGHT>(occupancy, squareBitboard) & bitboards[Piece{KNIGHT, attacker}.index()] & remainingPieces) != 0)
+    {
+        return true;
+    }
+    if ((movegen::getPieceAttackingSquares<BISHOP>(occupancy, squareBitboard) & (bitboards[Piece{BISHOP, attacker}.index()] | queens) & remainingPieces) != 0)
+    {
+        return true;
+    }
+    if ((movegen::getPieceAttackingSquares<ROOK>(occupancy, squareBitboard) & (bitboards[Piece{ROOK, attacker}.index()] | queens) & remainingPieces) != 0)
+    {
+        return true;
+    }
+    return (movegen::getPieceAttackingSquares<KING>(occupancy, squareBitboard) & bitboards[Piece{KING, attacker}.index()] & remainingPieces) != 0;
+}
+
+Bitboard Position::attackersTo(Square square, Bitboard occupancy) const
+{
+    const Bitboard squareBitboard = bitboards::withSquare(square);
+    const Bitboard bishops = bitboards[pieceIndexes::WHITE_BISHOP] | bitboards[pieceIndexes::BLACK_BISHOP];
+    const Bitboard rooks = bitboards[pieceIndexes::WHITE_ROOK] | bitboards[pieceIndexes::BLACK_ROOK];
+    const Bitboard queens = bitboards[pieceIndexes::WHITE_QUEEN] | bitboards[pieceIndexes::BLACK_QUEEN];
+
+    // A pawn attacks the square if a pawn of the other colour on the square would attack the pawn
+    return (movegen::getPawnAttackingSquares<BLACK>(squareBitboard) & bitboards[pieceIndexes::WHITE_PAWN]) |
+           (movegen::getPawnAttackingSquares<WHITE>(squareBitboard) & bitboards[pieceIndexes::BLACK_PAWN]) |
+           (movegen::getPieceAttackingSquares<KNIGHT>(occupancy, squareBitboard) &
+            (bitboards[pieceIndexes::WHITE_KNIGHT] | bitboards[pieceIndexes::BLACK_KNIGHT])) |
+           (movegen::bishopAttacks(square, occupancy) & (bishops | queens)) |
+           (movegen::rookAttacks(square, occupancy) & (rooks | queens)) |
+           (movegen::getPieceAttackingSquares<KING>(occupancy, squareBitboard) &
+            (bitboards[pieceIndexes::WHITE_KING] | bitboards[pieceIndexes::BLACK_KING]));
+}
+
+int Position::see(Move move) const
+{
+    if (move.moveFlag() == MoveFlag::ShortCastling || move.moveFlag() == MoveFlag::LongCastling)
+    {
+        return 0;
+    }
+    const Square end = move.end();
+    const Bitboard endBitboard = bitboards::withSquare(end);
+    const bool endIsBackRank = (endBitboard & (bitboards::RANK_1 | bitboards::RANK_8)) != 0;
+    const Bitboard diagonalSliders = bitboards[pieceIndexes::WHITE_BISHOP] | bitboards[pieceIndexes::BLACK_BISHOP] |
+                                     bitboards[pieceIndexes::WHITE_QUEEN] | bitboards[pieceIndexes::BLACK_QUEEN];
+    const Bitboard straightSliders = bitboards[pieceIndexes::WHITE_ROOK] | bitboards[pieceIndexes::BLACK_ROOK] |
+                                     bitboards[pieceIndexes::WHITE_QUEEN] | bitboards[pieceIndexes::BLACK_QUEEN];
+
+    // gains[i] is the material won by the side making the ith capture if the exchange stopped after it, and the value
+    // of the piece on the square is the value the next capture wins. There are at most 32 captures, one per piece.
+    std::array<int, 32> gains{};
+    Bitboard occupancy = allPieces & ~bitboards::withSquare(move.start());
+    int pieceOnSquare = pieceValue(pieceAt(move.start()).kind());
+    if (move.moveFlag() == MoveFlag::EnPassant)
+    {
+        occupancy &= ~bitboards::withSquare(sideToMove == WHITE ? end + 8 : end - 8);
+        gains[0] = PAWN_VALUE;
+    }
+    else
+    {
+        gains[0] = pieceValue(pieceAt(end).kind());
+    }
+    if (move.isPromotion())
+    {
+        pieceOnSquare = pieceValue(Piece{move.moveFlag(), sideToMove}.kind());
+        gains[0] += pieceOnSquare - PAWN_VALUE;
+    }
+
+    Bitboard attackers = attackersTo(end, occupancy) & occupancy;
+    PieceColor side = oppositeColor(sideToMove);
+    size_t captures = 0;
+    while (true)
+    {
+        const Bitboard sideAttackers = attackers & sidePieces[colorIndex(side)];
+        if (sideAttackers == 0)
+        {
+            break;
+        }
+        PieceKind kind = PAWN;
+        Bitboard attackersOfKind = 0;
+        for (const PieceKind k : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING})
+        {
+            attackersOfKind = sideAttackers & bitboards[Piece{k, side}.index()];
+            if (attackersOfKind != 0)
+            {
+                kind = k;
+                break;
+            }
+        }
+        // The king can't capture a defended piece
+        if (kind == KING && (attackers & sidePieces[colorIndex(oppositeColor(side))]) != 0)
+        {
+            break;
+        }
+
+        captures++;
+        gains[captures] = pieceOnSquare - gains[captures - 1];
+        pieceOnSquare = pieceValue(kind);
+        if (kind == PAWN && endIsBackRank)
+        {
+            gains[captures] += QUEEN_VALUE - PAWN_VALUE;
+            pieceOnSquare = QUEEN_VALUE;
+        }
+
+        // Removing the attacker can uncover a slider behind it on the same line
+        occupancy &= ~(attackersOfKind & -attackersOfKind);
+        if (kind == PAWN || kind == BISHOP || kind == QUEEN)
+        {
+            attackers |= movegen::bishopAttacks(end, occupancy) & diagonalSliders;
+        }
+        if (kind == ROOK || kind == QUEEN)
+        {
+            attackers |= movegen::rookAttacks(end, occupancy) & straightSliders;
+        }
+        attackers &= occupancy;
+        side = oppositeColor(side);
+    }
+
+    // Going back from the last capture, each side only makes its capture if that is better than stopping before it
+    while (captures > 0)
+    {
+        captures--;
+        gains[captures] = -std::max(-gains[captures], gains[captures + 1]);
+    }
+    return gains[0];
+}
+
+/**
+ * Zobrist keys from a fixed seed. SplitMix64 is used instead of std::mt19937 because it can be evaluated at compile
+ * time, so the keys are stored in the binary and nothing has to be generated at startup.
+ */
+consteval std::array<uint64_t, 12 * 64 + 1 + 4 + 8> generateRandomValues()
+{
+    std::array<uint64_t, 12 * 64 + 1 + 4 + 8> values{};
+    uint64_t state = 0;
+
+    for (uint64_t &value : values)
+    {
+        state += 0x9E3779B97F4A7C15;
+        uint64_t z = state;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EB;
+        value = z ^ (z >> 31);
+    }
+
+    return values;
+}
+
+constexpr std::array<uint64_t, 12 * 64 + 1 + 4 + 8> randomValues = generateRandomValues();
+
+// The piece keys are followed by the side to move key, the 4 castling right keys and the 8 en passant file keys
+constexpr size_t SIDE_TO_MOVE_KEY = 12 * 64;
+constexpr size_t WHITE_SHORT_CASTLING_KEY = SIDE_TO_MOVE_KEY + 1;
+constexpr size_t WHITE_LONG_CASTLING_KEY = SIDE_TO_MOVE_KEY + 2;
+constexpr size_t BLACK_SHORT_CASTLING_KEY = SIDE_TO_MOVE_KEY + 3;
+constexpr size_t BLACK_LONG_CASTLING_KEY = SIDE_TO_MOVE_KEY + 4;
+constexpr size_t EN_PASSANT_KEYS = SIDE_TO_MOVE_KEY + 5;
+
+uint64_t randomValueForPiece(Piece piece, Square position)
+{
+    auto pieceIndex = static_cast<uint8_t>(piece.kind());
+
+    if (piece.color() == BLACK)
+    {
+        pieceIndex += 6;
+    }
+
+    return randomValues[pieceIndex * 64 + position];
+}
+
+/**
+ * Computes the Zobrist hash of the current board state
+ */
+uint64_t Position::hash() const
+{
+    uint64_t result = 0;
+
+    for (const PieceColor color : {WHITE, BLACK})
+    {
+        for (const PieceKind kind : {PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING})
+        {
+            const Piece piece{kind, color};
+            Bitboard pieces = bitboards[piece.index()];
+            while (pieces != 0)
+            {
+                result ^= randomValueForPiece(piece, bitboards::popMSB(pieces));
+            }
+        }
+    }
+
+    if (sideToMove == BLACK)
+    {
+        result ^= randomValues[SIDE_TO_MOVE_KEY];
+    }
+    return result ^ castlingAndEnPassantKeys();
+}
+
+uint64_t Position::castlingAndEnPassantKeys() const
+{
+    uint64_t result = 0;
+    if (whiteCanShortCastle)
+    {
+        result ^= randomValues[WHITE_SHORT_CASTLING_KEY];
+    }
+    if (whiteCanLongCastle)
+    {
+        result ^= randomValues[WHITE_LONG_CASTLING_KEY];
+    }
+    if (blackCanShortCastle)
+    {
+        result ^= randomValues[BLACK_SHORT_CASTLING_KEY];
+    }
+    if (blackCanLongCastle)
+    {
+        result ^= randomValues[BLACK_LONG_CASTLING_KEY];
+    }
+    if (enPassantTargetSquare != -1)
+    {
+        result ^= randomValues[EN_PASSANT_KEYS + square::file(enPassantTargetSquare)];
+    }
+    return result;
+}
+
+/**
+ * Incrementally updates the Zobrist hash by only updating values affected by the move. This is significantly faster
+ * than the normal hash(). The given hash must not include the castling and en passant keys, and the keys of the
+ * castling rights and en passant square after the move (which must already be set) are added to it.
+ */
+uint64_t Position::hashAfterMove(Move move, Piece movingPiece, Piece capturedPiece, uint64_t currentHash) const
+{
+    const PieceColor side = movingPiece.color();
+    // Remove piece from starting square
+    currentHash ^= randomValueForPiece(movingPiece, move.start());
+    // Add the piece, or the piece it promotes to, to the new square
+    const Piece placedPiece = move.isPromotion() ? Piece{move.moveFlag(), side} : movingPiece;
+    currentHash ^= randomValueForPiece(placedPiece, move.end());
+    // Remove captured piece, which is behind the destination square for en passant
+    if (!capturedPiece.isNone())
+    {
+        Square capturedSquare = move.end();
+        if (move.moveFlag() == MoveFlag::EnPassant)
+        {
+            capturedSquare = side == WHITE ? move.end() + 8 : move.end() - 8;
+        }
+        currentHash ^= randomValueForPiece(capturedPiece, capturedSquare);
+    }
+
+    // The rook moves to the other side of the king when castling
+    const Piece rook{ROOK, side};
+    if (move.moveFlag() == MoveFlag::ShortCastling)
+    {
+        currentHash ^= randomValueForPiece(rook, move.end() + 1) ^ randomValueForPiece(rook, move.end() - 1);
+    }
+    else if (move.moveFlag() == MoveFlag::LongCastling)
+    {
+        currentHash ^= randomValueForPiece(rook, move.end() - 2) ^ randomValueForPiece(rook, move.end() + 1);
+    }
+
+    // Side to move has changed
+    currentHash ^= randomValues[SIDE_TO_MOVE_KEY];
+
+    return currentHash ^ castlingAndEnPassantKeys();
+}
+
+void Position::makeNullMove()
+{
+    if (enPassantTargetSquare != -1)
+    {
+        positionHash ^= randomValues[EN_PASSANT_KEYS + square::file(enPassantTargetSquare)];
+        enPassantTargetSquare = -1;
+    }
+    halfMoveClock++;
+    sideToMove = oppositeColor(sideToMove);
+    positionHash ^= randomValues[SIDE_TO_MOVE_KEY];
+    updateCheckInfo();
+}
+
+void Position::movePiece(Piece piece, Piece capturedPiece, Square start, Square end)
+{
+    const Bitboard startBitboard = bitboards::withSquare(start);
+    const Bitboard endBitboard = bitboards::withSquare(end);
+    // Remove captured piece
+    if (!capturedPiece.isNone())
+    {
+        bitboards[capturedPiece.index()] &= ~endBitboard;
+        sidePieces[colorIndex(capturedPiece.color())] &= ~endBitboard;
+        pieceCounts[capturedPiece.index()]--;
+    }
+    // Move piece
+    bitboards[piece.index()] &= ~startBitboard;
+    bitboards[piece.index()] |= endBitboard;
+    sidePieces[colorIndex(piece.color())] &= ~startBitboard;
+    sidePieces[colorIndex(piece.color())] |= endBitboard;
+    allPieces &= ~startBitboard;
+    allPieces |= endBitboard;
+    if (piece.kind() == KING)
+    {
+        kingSquares[colorIndex(piece.color())] = end;
+    }
+}
+
+void Position::addPiece(Piece piece, Square position)
+{
+    const Bitboard bitboard = bitboards::withSquare(position);
+    bitboards[piece.index()] |= bitboard;
+    sidePieces[colorIndex(piece.color())] |= bitboard;
+    allPieces |= bitboard;
+    pieceCounts[piece.index()]++;
+    if (piece.kind() == KING)
+    {
+        kingSquares[colorIndex(piece.color())] = position;
+    }
+}
+
+void Position::addPiece(MoveFlag promotedPiece, PieceColor side, Square position)
+{
+    addPiece(Piece{promotedPiece, side}, position);
+}
+
+void Position::removePiece(Piece piece, Square position)
+{
+    const Bitboard bitboard = bitboards::withSquare(position);
+    bitboards[piece.index()] &= ~bitboard;
+    sidePieces[colorIndex(piece.color())] &= ~bitboard;
+    allPieces &= ~bitboard;
+    pieceCounts[piece.index()]--;
+}
+
+void Position::removePiece(MoveFlag promotedPiece, PieceColor side, Square position)
+{
+    removePiece(Piece{promotedPiece, side}, position);
+}
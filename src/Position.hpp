@@ -0,0 +1,382 @@
+#pragma once
+
+#include "MoveList.hpp"
+#include "Piece.hpp"
+#include "bitboards.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+enum class TerminalStatus
+{
+    NONE,
+    CHECKMATE,
+    STALEMATE,
+    FIFTY_MOVE_RULE,
+    INSUFFICIENT_MATERIAL,
+    THREEFOLD_REPETITION
+};
+
+// Maximum number of plies that can be stored in the history of a game
+constexpr size_t MAX_GAME_LENGTH = 2048;
+
+/**
+ * Check and pin information for the side to move, computed once when a position is reached and used by move
+ * generation, check detection and move ordering
+ */
+struct CheckInfo
+{
+    // Pieces giving check to the king of the side to move
+    Bitboard checkers = 0;
+    // Pieces of the side to move that can only move along the line between their king and the piece pinning them
+    Bitboard pinned = 0;
+    // Squares that a piece other than the king can move to in order to capture or block the checking piece. This is
+    // every square when not in check, and no squares in double check.
+    Bitboard checkResolutions = bitboards::ALL_SQUARES;
+    // Squares from which a piece of the side to move would give check, indexed by PieceKind
+    std::array<Bitboard, 6> checkSquares{};
+    // Pieces of the side to move that are the only piece between one of its sliding pieces and the enemy king, so
+    // moving them off that line gives a discovered check
+    Bitboard discoveredCheckCandidates = 0;
+};
+
+/**
+ * Piece positions, side to move, castling rights, en passant square, halfmove clock and hash of a position, without any
+ * history. This is trivially copyable and takes four cache lines (80 of its 256 bytes are the check info, which saves
+ * recomputing it for move generation and check detection), so it can be used for copy-make (copying the position and
+ * making the move on the copy instead of making and unmaking it), for example in MCTS rollouts and on worker threads
+ * that need their own position. Board extends this with a mailbox and the history needed to unmake moves, and
+ * PositionHistory can be used to detect repetitions when making moves on a Position.
+ */
+class alignas(64) Position
+{
+  public:
+    // The hash is stored between the bitboards and the side to move so that the small fields are packed together
+    std::array<Bitboard, 14> bitboards{};
+
+  protected:
+    uint64_t positionHash = 0;
+
+    // Updated incrementally by movePiece(), addPiece() and removePiece(), indexed by colorIndex()
+    std::array<Bitboard, 2> sidePieces{};
+    Bitboard allPieces = 0;
+    std::array<uint8_t, 14> pieceCounts{};
+    std::array<Square, 2> kingSquares{};
+
+    CheckInfo checkInfo;
+
+  public:
+    PieceColor sideToMove = PieceColor::WHITE;
+
+    /**
+     * Replaces this position with the one described by a FEN string without allocating. The halfmove clock and fullmove
+     * number may be omitted, in which case the halfmove clock is 0. Throws std::invalid_argument if the FEN is invalid.
+     */
+    void loadFen(std::string_view fen);
+
+    /**
+     * Replaces this position with the one described by the first 4 fields of an EPD line and returns the operations
+     * that follow them (for example "bm e4; id \"test 1\";"), which point into the given line. Throws
+     * std::invalid_argument if the position is invalid.
+     */
+    std::string_view loadEpd(std::string_view epd);
+
+    /**
+     * Makes a move without storing anything needed to unmake it
+     */
+    void makeMove(Move move);
+
+    /**
+     * Makes a move for Side, which must be the side to move. Callers that already know the side to move, such as a
+     * search templated on the colour, can call this directly to skip the dispatch in makeMove(Move).
+     */
+    template <PieceColor Side>
+    void makeMove(Move move);
+
+    /**
+     * Passes the turn to the opponent without moving a piece. This is not a legal move and is only used for null move
+     * pruning, so it should not be made when the side to move is in check.
+     */
+    void makeNullMove();
+
+    MoveList getLegalMoves() const;
+    template <PieceColor Side>
+    MoveList getLegalMoves() const;
+    /**
+     * Returns the number of legal moves without generating them, which is much faster when only the count is needed
+     */
+    size_t countLegalMoves() const;
+    template <PieceColor Side>
+    size_t countLegalMoves() const;
+    /**
+     * Returns the legal captures, including en passant, and promotions
+     */
+    CaptureList getLegalCaptures() const;
+    Bitboard getSlidingPieces(PieceColor side) const;
+    Piece pieceAt(Square square) const;
+
+    /**
+     * Checks whether a move that didn't come from the move generator, such as a move from the transposition table or a
+     * killer move, could be made by the side to move in this position, without checking whether it leaves the king in
+     * check. Any move value is accepted, including ones from a different position after a hash collision.
+     */
+    bool isPseudoLegal(Move move) const;
+
+    /**
+     * Checks whether a pseudo-legal move leaves the king of the side to move safe. The result is only meaningful for
+     * moves that isPseudoLegal() accepts. Moves of pieces other than the king that aren't pinned are decided from the
+     * check info without looking at any attacks, so this is cheap enough to call on every pseudo-legal move that is
+     * searched.
+     */
+    bool isLegal(Move move) const;
+
+    /**
+     * Checks whether a legal move gives check, including discovered checks, without making the move
+     */
+    bool givesCheck(Move move) const;
+
+    Bitboard getPieces(PieceColor color) const
+    {
+        return sidePieces[colorIndex(color)];
+    }
+
+    Bitboard getPieces() const
+    {
+        return allPieces;
+    }
+
+    uint8_t getPieceCount(Piece piece) const
+    {
+        return pieceCounts[piece.index()];
+    }
+
+    Square getKingSquare(PieceColor side) const
+    {
+        return kingSquares[colorIndex(side)];
+    }
+
+    const CheckInfo &getCheckInfo() const
+    {
+        return checkInfo;
+    }
+
+    bool isSideInCheck(PieceColor side) const
+    {
+        if (side == sideToMove)
+        {
+            return checkInfo.checkers != 0;
+        }
+        return isSquareAttacked(getKingSquare(side), oppositeColor(side));
+    }
+
+    bool isCheck() const
+    {
+        return isSideInCheck(PieceColor::WHITE) || isSideInCheck(PieceColor::BLACK);
+    }
+
+    bool isCheckmate(PieceColor side) const
+    {
+        return sideToMove == side && isSideInCheck(side) && getLegalMoves().empty();
+    }
+
+    int8_t getEnPassantTargetSquare() const
+    {
+        return enPassantTargetSquare;
+    }
+
+    /**
+     * Computes the squares attacked by the given side. This is not stored and is computed every time it is called,
+     * so isSquareAttacked() should be preferred when only a single square is needed.
+     */
+    Bitboard getAttackingSquares(PieceColor side) const
+    {
+        return getAttackingSquares(side, getPieces());
+    }
+
+    Bitboard getAttackingSquares(PieceColor side, Bitboard occupancy) const;
+    template <PieceColor Side>
+    Bitboard getAttackingSquares(Bitboard occupancy) const;
+
+    bool isSquareAttacked(Square square, PieceColor attacker) const
+    {
+        return isSquareAttacked(square, attacker, getPieces());
+    }
+
+    /**
+     * Checks whether a square would be attacked with the given occupancy, ignoring any attacking pieces on the squares in
+     * removedPieces. This can be used to check whether a square is attacked after a move without making it.
+     */
+    bool isSquareAttacked(Square square, PieceColor attacker, Bitboard occupancy, Bitboard removedPieces = 0) const;
+
+    /**
+     * Returns the pieces of both sides that attack a square, with sliding pieces blocked by the given occupancy. Pieces
+     * that aren't in the occupancy are still included if they attack the square, so callers that remove pieces from the
+     * occupancy should also remove them from the result.
+     */
+    Bitboard attackersTo(Square square, Bitboard occupancy) const;
+
+    /**
+     * Static exchange evaluation: the material the side to move wins with a capture or promotion if both sides then
+     * keep recapturing on the destination square with their least valuable attacker, each side stopping when
+     * recapturing would lose material. Sliding pieces behind other attackers join in once the pieces in front of them
+     * have captured. Pins, checks and everything away from the destination square are ignored.
+     */
+    int see(Move move) const;
+
+    bool isSquareEmpty(Square square) const
+    {
+        return (getPieces() & bitboards::withSquare(square)) == 0;
+    }
+
+    bool canWhiteShortCastle() const
+    {
+        return whiteCanShortCastle;
+    }
+
+    bool canWhiteLongCastle() const
+    {
+        return whiteCanLongCastle;
+    }
+
+    bool canBlackShortCastle() const
+    {
+        return blackCanShortCastle;
+    }
+
+    bool canBlackLongCastle() const
+    {
+        return blackCanLongCastle;
+    }
+
+    uint64_t getHash() const
+    {
+        return positionHash;
+    }
+
+    /**
+     * Computes the Zobrist hash of the position from scratch, which is always the same as the incrementally updated
+     * getHash()
+     */
+    uint64_t hash() const;
+
+    uint8_t getHalfMoveClock() const
+    {
+        return halfMoveClock;
+    }
+
+    bool isStalemate() const;
+    bool isInsufficientMaterial() const;
+    bool isDrawByFiftyMoveRule() const;
+
+    /**
+     * Checks for draws that can be detected from the position alone. This doesn't include repetitions, which need the
+     * history of the game.
+     */
+    bool isDraw() const;
+
+    /**
+     * Determines whether the game has ended in this position, and how, using the legal moves in this position which
+     * the caller will usually have generated already. This doesn't include repetitions, which need the history of the
+     * game.
+     */
+    TerminalStatus terminalStatus(const MoveList &legalMoves) const;
+
+    TerminalStatus terminalStatus() const
+    {
+        return terminalStatus(getLegalMoves());
+    }
+
+  protected:
+    int8_t enPassantTargetSquare = -1;
+
+    bool whiteCanShortCastle = false;
+    bool whiteCanLongCastle = false;
+    bool blackCanShortCastle = false;
+    bool blackCanLongCastle = false;
+
+    uint8_t halfMoveClock = 0;
+
+    /**
+     * Parses the placement, side to move, castling and en passant fields shared by FEN and EPD, and returns the rest of
+     * the text
+     */
+    std::string_view parsePositionFields(std::string_view text);
+
+    uint64_t hashAfterMove(Move move, Piece movingPiece, Piece capturedPiece, uint64_t currentHash) const;
+
+    /**
+     * Zobrist keys of the castling rights and en passant square, which are part of the hash
+     */
+    uint64_t castlingAndEnPassantKeys() const;
+
+    /**
+     * Updates the bitboards, castling rights, en passant square, halfmove clock, side to move and hash for a move
+     * where the moving and captured pieces are already known
+     */
+    template <PieceColor Side>
+    void applyMove(Move move, Piece movedPiece, Piece capturedPiece);
+
+    /**
+     * Recomputes the check info after the pieces or the side to move have changed
+     */
+    void updateCheckInfo();
+
+    void movePiece(Piece piece, Piece capturedPiece, Square start, Square end);
+    void addPiece(Piece piece, Square position);
+    void addPiece(MoveFlag promotedPiece, PieceColor side, Square position);
+    void removePiece(Piece piece, Square position);
+    void removePiece(MoveFlag promotedPiece, PieceColor side, Square position);
+
+    static uint8_t colorIndex(PieceColor color)
+    {
+        return static_cast<uint8_t>(color) >> 3;
+    }
+};
+
+/**
+ * Hashes of the positions reached in a game, kept separately from a Position so that repetitions can be detected when
+ * using copy-make.
+ */
+class PositionHistory
+{
+  public:
+    void push(uint64_t hash)
+    {
+        if (count >= MAX_GAME_LENGTH)
+            [[unlikely]]
+        {
+            throw std::runtime_error{"Maximum game length exceeded"};
+        }
+        hashes[count++] = hash;
+    }
+
+    /**
+     * Checks whether the last position has occurred at least 3 times. Only every other position since the last
+     * irreversible move can be a repetition, so the number of positions checked is limited by the halfmove clock.
+     */
+    bool isThreefoldRepetition(uint8_t halfMoveClock) const
+    {
+        const int64_t last = static_cast<int64_t>(count) - 1;
+        const int64_t earliest = std::max<int64_t>(last - halfMoveClock, 0);
+        int repetitions = 1;
+        for (int64_t i = last - 4; i >= earliest; i -= 2)
+        {
+            if (hashes[i] == hashes[last] && ++repetitions >= 3)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+  private:
+    std::array<uint64_t, MAX_GAME_LENGTH> hashes;
+    size_t count = 0;
+};
@@ -0,0 +1,317 @@
+#include "bench.hpp"
+#include "Board.hpp"
+#include "epd.hpp"
+#include "movegen.hpp"
+#include "search.hpp"
+#include "tests.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+
+using std::chrono::system_clock;
+
+double secondsSince(system_clock::time_point start)
+{
+    return std::chrono::duration<double>(system_clock::now() - start).count();
+}
+
+size_t copyMakePerft(const Position &position, uint8_t depth)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+    MoveList moves = position.getLegalMoves();
+    if (depth == 1)
+    {
+        return moves.size();
+    }
+
+    size_t positionsReached = 0;
+    for (const Move move : moves)
+    {
+        Position positionAfterMove = position;
+        positionAfterMove.makeMove(move);
+        positionsReached += copyMakePerft(positionAfterMove, depth - 1);
+    }
+    return positionsReached;
+}
+
+void benchPerft()
+{
+    size_t totalNodes = 0;
+    double totalSeconds = 0;
+    double totalCopyMakeSeconds = 0;
+
+    for (const auto &[depth, fen, expectedValue] : PERFT_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(fen);
+        auto start = system_clock::now();
+        const size_t nodes = perft(board, depth - 1, true, false);
+        const double seconds = secondsSince(start);
+
+        start = system_clock::now();
+        const size_t copyMakeNodes = copyMakePerft(board, depth - 1);
+        const double copyMakeSeconds = secondsSince(start);
+
+        if (nodes != copyMakeNodes)
+        {
+            std::cout << fen << ": copy-make perft mismatch (" << nodes << " vs " << copyMakeNodes << ")\n";
+        }
+        totalNodes += nodes;
+        totalSeconds += seconds;
+        totalCopyMakeSeconds += copyMakeSeconds;
+        std::cout << fen << ": " << nodes << " nodes, " << static_cast<size_t>(nodes / seconds) << " nps, "
+                  << static_cast<size_t>(nodes / copyMakeSeconds) << " nps (copy-make)\n";
+    }
+
+    std::cout << "perft: " << totalNodes << " nodes in " << totalSeconds << "s, "
+              << static_cast<size_t>(totalNodes / totalSeconds) << " nps\n";
+    std::cout << "perft (copy-make): " << totalNodes << " nodes in " << totalCopyMakeSeconds << "s, "
+              << static_cast<size_t>(totalNodes / totalCopyMakeSeconds) << " nps\n";
+}
+
+template <movegen::SliderIndexing Indexing>
+void benchSliderAttacks(const std::string &name, const std::vector<Bitboard> &occupancies, size_t iterations)
+{
+    Bitboard result = 0;
+    const auto start = system_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        for (const Bitboard occupancy : occupancies)
+        {
+            for (Square square = 0; square < 64; square++)
+            {
+                result += movegen::rookAttacks<Indexing>(square, occupancy);
+                result += movegen::bishopAttacks<Indexing>(square, occupancy);
+            }
+        }
+    }
+    const double seconds = secondsSince(start);
+
+    const size_t lookups = iterations * occupancies.size() * 64 * 2;
+    // The result is printed so that the lookups can't be optimised away
+    std::cout << "slider attacks (" << name << ", checksum " << (result & 0xFFFF) << "): " << lookups << " lookups in "
+              << seconds << "s, " << static_cast<size_t>(lookups / seconds) << " lookups/s\n";
+}
+
+void benchSliderAttacks(size_t iterations)
+{
+    // Random occupancies with about a quarter of the squares filled, like a middlegame position
+    std::mt19937_64 rng; // NOLINT(*-msc51-cpp)
+    std::vector<Bitboard> occupancies(1024);
+    for (Bitboard &occupancy : occupancies)
+    {
+        occupancy = rng() & rng();
+    }
+
+    benchSliderAttacks<movegen::SliderIndexing::MAGIC>("magic", occupancies, iterations);
+#ifdef __BMI2__
+    benchSliderAttacks<movegen::SliderIndexing::PEXT>("pext", occupancies, iterations);
+#endif
+    std::cout << "move generation uses "
+              << (movegen::SLIDER_INDEXING == movegen::SliderIndexing::PEXT ? "pext" : "magic") << "\n";
+}
+
+template <movegen::AttackKernel Kernel>
+void benchAttackMaps(const std::string &name, const std::vector<Position> &positions, size_t iterations)
+{
+    Bitboard result = 0;
+    const auto start = system_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+    {
+        for (const Position &position : positions)
+        {
+            const movegen::AttackMaps attackMaps = movegen::computeAttackMaps<Kernel>(position, position.getPieces());
+            result += attackMaps.white ^ attackMaps.black;
+        }
+    }
+    const double seconds = secondsSince(start);
+
+    const size_t computed = iterations * positions.size();
+    // The result is printed so that the attack maps can't be optimised away
+    std::cout << "attack maps (" << name << ", checksum " << (result & 0xFFFF) << "): " << computed
+              << " positions in " << seconds << "s, " << static_cast<size_t>(computed / seconds) << " positions/s\n";
+}
+
+void benchAttackMaps(size_t iterations)
+{
+    // Every position two plies from the perft test positions, split by the number of pieces on the board
+    std::vector<Position> sparsePositions;
+    std::vector<Position> densePositions;
+    for (const auto &[depth, fen, expectedValue] : PERFT_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(fen);
+        for (const Move move : board.getLegalMoves())
+        {
+            board.makeMove(move);
+            for (const Move reply : board.getLegalMoves())
+            {
+                board.makeMove(reply);
+                (std::popcount(board.getPieces()) <= 16 ? sparsePositions : densePositions).push_back(board);
+                board.unmakeMove();
+            }
+            board.unmakeMove();
+        }
+    }
+
+    for (const auto &[name, positions] : {std::pair{"sparse", &sparsePositions}, std::pair{"dense", &densePositions}})
+    {
+        benchAttackMaps<movegen::AttackKernel::LOOKUP>(std::string{name} + " lookup", *positions, iterations);
+#ifdef __AVX2__
+        benchAttackMaps<movegen::AttackKernel::KOGGE_STONE>(std::string{name} + " kogge-stone", *positions, iterations);
+#endif
+    }
+    std::cout << "attack maps use "
+              << (movegen::ATTACK_KERNEL == movegen::AttackKernel::KOGGE_STONE ? "kogge-stone" : "lookup") << "\n";
+}
+
+void benchMakeUnmake(size_t iterations)
+{
+    size_t totalMoves = 0;
+    double totalSeconds = 0;
+
+    for (const auto &[depth, fen, expectedValue] : PERFT_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(fen);
+        MoveList moves = board.getLegalMoves();
+        const auto start = system_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            for (const Move move : moves)
+            {
+                board.makeMove(move);
+                board.unmakeMove();
+            }
+        }
+        totalSeconds += secondsSince(start);
+        totalMoves += moves.size() * iterations;
+    }
+
+    std::cout << "make/unmake: " << totalMoves << " moves in " << totalSeconds << "s, "
+              << static_cast<size_t>(totalMoves / totalSeconds) << " moves/s\n";
+}
+
+void benchCopyMake(size_t iterations)
+{
+    size_t totalMoves = 0;
+    double totalSeconds = 0;
+
+    for (const auto &[depth, fen, expectedValue] : PERFT_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(fen);
+        const Position position = board;
+        MoveList moves = position.getLegalMoves();
+        const auto start = system_clock::now();
+        for (size_t i = 0; i < iterations; i++)
+        {
+            for (const Move move : moves)
+            {
+                Position positionAfterMove = position;
+                positionAfterMove.makeMove(move);
+            }
+        }
+        totalSeconds += secondsSince(start);
+        totalMoves += moves.size() * iterations;
+    }
+
+    std::cout << "copy-make: " << totalMoves << " moves in " << totalSeconds << "s, "
+              << static_cast<size_t>(totalMoves / totalSeconds) << " moves/s\n";
+}
+
+void benchSearch(uint8_t depth)
+{
+    uint64_t totalPositions = 0;
+    double totalSeconds = 0;
+
+    for (const auto &[perftDepth, fen, expectedValue] : PERFT_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(fen);
+        resetSearchState();
+        clearTranspositionTable();
+        const auto start = system_clock::now();
+        const SearchResult result = bestMove(board, depth);
+        const double seconds = secondsSince(start);
+
+        totalPositions += result.debugStats.positionsEvaluated;
+        totalSeconds += seconds;
+        std::cout << fen << ": " << static_cast<std::string>(result.bestMove) << ", "
+                  << result.debugStats.positionsEvaluated << " positions in " << seconds << "s\n";
+    }
+
+    std::cout << "search depth " << static_cast<int>(depth) << ": " << totalPositions << " positions in "
+              << totalSeconds << "s, " << static_cast<size_t>(totalPositions / totalSeconds) << " positions/s\n";
+}
+
+void benchFenParsing(size_t lines)
+{
+    std::vector<std::string> fens;
+    for (size_t i = 0; fens.size() < lines; i++)
+    {
+        fens.push_back(PERFT_TEST_POSITIONS[i % PERFT_TEST_POSITIONS.size()].fen);
+    }
+
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_bench.epd";
+    {
+        std::ofstream file{path};
+        for (size_t i = 0; i < fens.size(); i++)
+        {
+            // The first 4 FEN fields are the EPD position
+            const std::string_view fen = fens[i];
+            size_t fieldsEnd = 0;
+            for (int field = 0; field < 4; field++)
+            {
+                fieldsEnd = fen.find(' ', fieldsEnd + 1);
+            }
+            file << fen.substr(0, fieldsEnd) << " bm e4; id \"bench " << i << "\"; c0 \"perft; position\";\n";
+        }
+    }
+
+    Position position;
+    uint64_t checksum = 0;
+    auto start = system_clock::now();
+    for (const std::string &fen : fens)
+    {
+        position.loadFen(fen);
+        checksum ^= position.getHash();
+    }
+    const double fenSeconds = secondsSince(start);
+
+    const unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    start = system_clock::now();
+    size_t epdLines = 0;
+    {
+        const EpdFile file{path.string()};
+        const std::vector<EpdEntry> entries = file.load(threadCount);
+        epdLines = entries.size();
+        checksum ^= entries.back().position.getHash();
+    }
+    const double epdSeconds = secondsSince(start);
+    std::filesystem::remove(path);
+
+    std::cout << "FEN parsing: " << fens.size() << " lines in " << fenSeconds << "s, "
+              << static_cast<size_t>(fens.size() / fenSeconds) << " lines/s\n";
+    std::cout << "EPD loading (" << threadCount << " threads): " << epdLines << " lines in " << epdSeconds << "s, "
+              << static_cast<size_t>(epdLines / epdSeconds) << " lines/s\n";
+    // Printed so that the parsing can't be optimised away
+    std::cout << "checksum " << checksum << "\n";
+}
+
+void runBenchmarks()
+{
+    benchMakeUnmake(20000);
+    benchCopyMake(20000);
+    benchSliderAttacks(100);
+    benchAttackMaps(100);
+    benchPerft();
+    benchSearch(4);
+    benchFenParsing(1000000);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Runs the perft test positions one ply shallower than the tests and reports the total nodes per second, using both
+ * make/unmake on a Board and copy-make on a Position
+ */
+void benchPerft();
+
+/**
+ * Makes and unmakes every legal move in each of the perft test positions and reports the number of make/unmake pairs
+ * per second
+ */
+void benchMakeUnmake(size_t iterations);
+
+/**
+ * Same as benchMakeUnmake(), but copies the position and makes the move on the copy instead of unmaking it
+ */
+void benchCopyMake(size_t iterations);
+
+/**
+ * Searches each of the perft test positions to a fixed depth with an empty transposition table and reports the number
+ * of positions evaluated and the time taken to reach that depth
+ */
+void benchSearch(uint8_t depth);
+
+/**
+ * Writes an EPD file with the perft test positions repeated until it has the given number of lines, then reports the
+ * number of lines per second parsed by Position::loadFen() and by EpdFile::load() on all cores
+ */
+void benchFenParsing(size_t lines);
+
+/**
+ * Looks up rook and bishop attacks on every square for a set of random occupancies, and reports the lookups per second
+ * for magic indexing and, when compiled for a target with BMI2, PEXT indexing
+ */
+void benchSliderAttacks(size_t iterations);
+
+/**
+ * Computes the attack maps of both sides in the positions two plies from the perft test positions, and reports the
+ * positions per second for sparse (at most 16 pieces) and dense positions with the lookup kernel and, when compiled for
+ * a target with AVX2, the Kogge-Stone kernel
+ */
+void benchAttackMaps(size_t iterations);
+
+void runBenchmarks();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Square.hpp"
+#include <bit>
 #include <cstdint>
 #include <vector>
 
@@ -16,17 +17,28 @@ constexpr Bitboard withSquare(Square square)
 /**
  * Returns the index of the most significant bit and removes it from the bitboard
  */
-Square popMSB(Bitboard &bitboard);
+constexpr Square popMSB(Bitboard &bitboard)
+{
+    const Square index = std::countl_zero(bitboard);
+    bitboard &= ~withSquare(index);
+    return index;
+}
 
 /**
  * Returns the index of the most significant bit
  */
-Square getMSB(Bitboard bitboard);
+constexpr Square getMSB(Bitboard bitboard)
+{
+    return std::countl_zero(bitboard);
+}
 
 /**
- * Returns the index of the most significant bit
+ * Returns the index of the least significant bit
  */
-Square getLSB(Bitboard bitboard);
+constexpr Square getLSB(Bitboard bitboard)
+{
+    return 63 - std::countr_zero(bitboard);
+}
 
 std::vector<Square> squaresOf(Bitboard bitboard);
 constexpr Bitboard ALL_SQUARES = 0xFFFFFFFFFFFFFFFF;
@@ -0,0 +1,250 @@
+#include "epd.hpp"
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+#ifdef _WIN32
+#define NOMINMAX
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::string_view trimWhitespace(std::string_view text)
+{
+    const size_t start = text.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos)
+    {
+        return {};
+    }
+    const size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(start, end - start + 1);
+}
+
+std::string_view epdOperation(std::string_view operations, std::string_view opcode)
+{
+    while (!operations.empty())
+    {
+        // Find the end of this operation, ignoring semicolons inside quoted strings
+        size_t end = 0;
+        bool inQuotes = false;
+        while (end < operations.size() && (inQuotes || operations[end] != ';'))
+        {
+            if (operations[end] == '"')
+            {
+                inQuotes = !inQuotes;
+            }
+            end++;
+        }
+
+        const std::string_view operation = trimWhitespace(operations.substr(0, end));
+        operations.remove_prefix(std::min(end + 1, operations.size()));
+
+        const size_t opcodeEnd = std::min(operation.find_first_of(" \t"), operation.size());
+        if (operation.substr(0, opcodeEnd) != opcode)
+        {
+            continue;
+        }
+        std::string_view operand = trimWhitespace(operation.substr(opcodeEnd));
+        if (operand.size() >= 2 && operand.front() == '"' && operand.back() == '"')
+        {
+            operand = operand.substr(1, operand.size() - 2);
+        }
+        return operand;
+    }
+    return {};
+}
+
+/**
+ * Calls the function with each non-empty line of the text, without any surrounding whitespace
+ */
+template <typename Function>
+void forEachLine(std::string_view text, Function &&function)
+{
+    while (!text.empty())
+    {
+        const size_t lineEnd = std::min(text.find('\n'), text.size());
+        const std::string_view line = trimWhitespace(text.substr(0, lineEnd));
+        text.remove_prefix(std::min(lineEnd + 1, text.size()));
+        if (!line.empty())
+        {
+            function(line);
+        }
+    }
+}
+
+EpdEntry parseEpdLine(std::string_view line)
+{
+    EpdEntry entry;
+    entry.operations = entry.position.loadEpd(line);
+    entry.bestMoves = epdOperation(entry.operations, "bm");
+    entry.id = epdOperation(entry.operations, "id");
+    entry.comment = epdOperation(entry.operations, "c0");
+    return entry;
+}
+
+EpdFile::EpdFile(const std::string &path)
+{
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        fileHandle = nullptr;
+        throw std::runtime_error{"Failed to open " + path};
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize))
+    {
+        CloseHandle(fileHandle);
+        throw std::runtime_error{"Failed to read the size of " + path};
+    }
+    size = static_cast<size_t>(fileSize.QuadPart);
+    if (size == 0)
+    {
+        return;
+    }
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr)
+    {
+        CloseHandle(fileHandle);
+        throw std::runtime_error{"Failed to map " + path};
+    }
+    data = static_cast<const char *>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr)
+    {
+        CloseHandle(mappingHandle);
+        CloseHandle(fileHandle);
+        throw std::runtime_error{"Failed to map " + path};
+    }
+#else
+    fileDescriptor = open(path.c_str(), O_RDONLY);
+    if (fileDescriptor == -1)
+    {
+        throw std::runtime_error{"Failed to open " + path};
+    }
+    struct stat fileStatus{};
+    if (fstat(fileDescriptor, &fileStatus) == -1)
+    {
+        close(fileDescriptor);
+        throw std::runtime_error{"Failed to read the size of " + path};
+    }
+    size = static_cast<size_t>(fileStatus.st_size);
+    if (size == 0)
+    {
+        return;
+    }
+    void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (mapping == MAP_FAILED)
+    {
+        close(fileDescriptor);
+        throw std::runtime_error{"Failed to map " + path};
+    }
+    // The file is read from start to end by each thread
+    madvise(mapping, size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(mapping);
+#endif
+}
+
+EpdFile::~EpdFile()
+{
+#ifdef _WIN32
+    if (data != nullptr)
+    {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr)
+    {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (data != nullptr)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+    if (fileDescriptor != -1)
+    {
+        close(fileDescriptor);
+    }
+#endif
+}
+
+std::vector<EpdEntry> EpdFile::load(unsigned int threadCount) const
+{
+    const std::string_view text = contents();
+    threadCount = std::max(threadCount, 1u);
+
+    // Each chunk starts at the beginning of a line, so that every line is parsed by exactly one thread
+    std::vector<size_t> chunkStarts(threadCount + 1, text.size());
+    chunkStarts[0] = 0;
+    for (unsigned int i = 1; i < threadCount; i++)
+    {
+        const size_t lineEnd = text.find('\n', std::max(text.size() * i / threadCount, chunkStarts[i - 1]));
+        chunkStarts[i] = lineEnd == std::string_view::npos ? text.size() : lineEnd + 1;
+    }
+
+    const auto runOnChunks = [&](auto &&parseChunk)
+    {
+        std::vector<std::exception_ptr> errors(threadCount);
+        std::vector<std::thread> threads;
+        threads.reserve(threadCount);
+        for (unsigned int i = 0; i < threadCount; i++)
+        {
+            threads.emplace_back(
+                [&, i]
+                {
+                    try
+                    {
+                        parseChunk(i, text.substr(chunkStarts[i], chunkStarts[i + 1] - chunkStarts[i]));
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+        }
+        for (std::thread &thread : threads)
+        {
+            thread.join();
+        }
+        for (const std::exception_ptr &error : errors)
+        {
+            if (error != nullptr)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    // Count the lines in each chunk first so that every thread can write its entries directly into the result
+    std::vector<size_t> chunkOffsets(threadCount + 1, 0);
+    runOnChunks(
+        [&](unsigned int i, std::string_view chunk)
+        {
+            forEachLine(chunk, [&](std::string_view)
+                        { chunkOffsets[i + 1]++; });
+        });
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        chunkOffsets[i + 1] += chunkOffsets[i];
+    }
+
+    std::vector<EpdEntry> entries(chunkOffsets[threadCount]);
+    runOnChunks(
+        [&](unsigned int i, std::string_view chunk)
+        {
+            size_t entryIndex = chunkOffsets[i];
+            forEachLine(chunk, [&](std::string_view line)
+                        { entries[entryIndex++] = parseEpdLine(line); });
+        });
+    return entries;
+}
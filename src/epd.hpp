@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Position.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * A position from an EPD file. The operations are views into the file they were loaded from, so they are only valid
+ * while the EpdFile is open.
+ */
+struct EpdEntry
+{
+    Position position;
+    // Best moves in SAN, separated by spaces
+    std::string_view bestMoves;
+    std::string_view id;
+    std::string_view comment;
+    // All operations, including ones that aren't parsed into their own fields
+    std::string_view operations;
+};
+
+/**
+ * Finds the operand of an EPD operation (for example "e4 d4" for bm or "test 1" for id "test 1";) in the operations
+ * part of an EPD line, without the surrounding quotes. Returns an empty view if the operation isn't present.
+ */
+std::string_view epdOperation(std::string_view operations, std::string_view opcode);
+
+/**
+ * Parses a single EPD line. Throws std::invalid_argument if the position is invalid.
+ */
+EpdEntry parseEpdLine(std::string_view line);
+
+/**
+ * A read-only memory mapped EPD file, which can be loaded without copying the file into strings
+ */
+class EpdFile
+{
+  public:
+    explicit EpdFile(const std::string &path);
+    ~EpdFile();
+    EpdFile(const EpdFile &) = delete;
+    EpdFile &operator=(const EpdFile &) = delete;
+
+    std::string_view contents() const
+    {
+        return {data, size};
+    }
+
+    /**
+     * Parses every non-empty line of the file, splitting the file into one contiguous chunk per thread. The entries are
+     * in the same order as the lines in the file. Throws std::invalid_argument if any line is invalid.
+     */
+    std::vector<EpdEntry> load(unsigned int threadCount) const;
+
+  private:
+    const char *data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#else
+    int fileDescriptor = -1;
+#endif
+};
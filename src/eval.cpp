@@ -5,7 +5,7 @@
 #include <cmath>
 #include <iostream>
 
-std::array<int, 64> switchOpeningWeightSide(std::array<int, 64> weights)
+constexpr std::array<int, 64> switchOpeningWeightSide(std::array<int, 64> weights)
 {
     // Reverse ranks (assuming weights are symmetrical)
     // Array is copied so this is fine
@@ -17,7 +17,7 @@ std::array<int, 64> switchOpeningWeightSide(std::array<int, 64> weights)
     return weights;
 }
 
-const std::array<int, 64> whitePawnOpeningWeights = {
+constexpr std::array<int, 64> whitePawnOpeningWeights = {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -27,7 +27,7 @@ const std::array<int, 64> whitePawnOpeningWeights = {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0};
 
-const std::array<int, 64> whiteKnightOpeningWeights = {
+constexpr std::array<int, 64> whiteKnightOpeningWeights = {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -37,7 +37,7 @@ const std::array<int, 64> whiteKnightOpeningWeights = {
     0, 0, 0, 2, 2, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0};
 
-const std::array<int, 64> whiteKingOpeningWeights = {
+constexpr std::array<int, 64> whiteKingOpeningWeights = {
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
     0, 0, 0, 0, 0, 0, 0, 0,
@@ -47,18 +47,18 @@ const std::array<int, 64> whiteKingOpeningWeights = {
     0, 0, 0, 0, 0, 0, 0, 0,
     5, 5, 2, 0, 0, 2, 5, 5};
 
-const std::array<int, 64> blackPawnOpeningWeights = switchOpeningWeightSide(whitePawnOpeningWeights);
-const std::array<int, 64> blackKnightOpeningWeights = switchOpeningWeightSide(whiteKnightOpeningWeights);
-const std::array<int, 64> blackKingOpeningWeights = switchOpeningWeightSide(whiteKingOpeningWeights);
-const std::array<int, 64> centerDistances = []()
+constexpr std::array<int, 64> blackPawnOpeningWeights = switchOpeningWeightSide(whitePawnOpeningWeights);
+constexpr std::array<int, 64> blackKnightOpeningWeights = switchOpeningWeightSide(whiteKnightOpeningWeights);
+constexpr std::array<int, 64> blackKingOpeningWeights = switchOpeningWeightSide(whiteKingOpeningWeights);
+constexpr std::array<int, 64> centerDistances = []()
 {
     std::array<int, 64> distances{};
 
-    for (int i = 0; i < 64; i++)
+    for (Square i = 0; i < 64; i++)
     {
-        const auto edgeDist = movegen::getEdgeDistances()[i];
-        const int x = std::min(edgeDist.WEST, edgeDist.EAST);
-        const int y = std::min(edgeDist.NORTH, edgeDist.SOUTH);
+        // Distances to the nearest edge horizontally and vertically
+        const int x = std::min(square::file(i) - 1, 8 - square::file(i));
+        const int y = std::min(square::rank(i) - 1, 8 - square::rank(i));
         distances[i] = 6 - (x + y);
     }
 
@@ -84,53 +84,60 @@ uint16_t pieceValue(PieceKind kind)
     }
 }
 
-int whiteMaterial(const Board &board)
+template <PieceColor Side>
+int material(const Board &board)
 {
-    using namespace pieceIndexes;
     int m = 0;
-    m += std::popcount(board.bitboards[WHITE_PAWN]) * PAWN_VALUE;
-    m += std::popcount(board.bitboards[WHITE_KNIGHT]) * KNIGHT_VALUE;
-    m += std::popcount(board.bitboards[WHITE_BISHOP]) * BISHOP_VALUE;
-    m += std::popcount(board.bitboards[WHITE_ROOK]) * ROOK_VALUE;
-    m += std::popcount(board.bitboards[WHITE_QUEEN]) * QUEEN_VALUE;
+    m += board.getPieceCount(Piece{PieceKind::PAWN, Side}) * PAWN_VALUE;
+    m += board.getPieceCount(Piece{PieceKind::KNIGHT, Side}) * KNIGHT_VALUE;
+    m += board.getPieceCount(Piece{PieceKind::BISHOP, Side}) * BISHOP_VALUE;
+    m += board.getPieceCount(Piece{PieceKind::ROOK, Side}) * ROOK_VALUE;
+    m += board.getPieceCount(Piece{PieceKind::QUEEN, Side}) * QUEEN_VALUE;
     return m;
 }
 
+int whiteMaterial(const Board &board)
+{
+    return material<PieceColor::WHITE>(board);
+}
+
 int blackMaterial(const Board &board)
 {
-    using namespace pieceIndexes;
-    int m = 0;
-    m += std::popcount(board.bitboards[BLACK_PAWN]) * PAWN_VALUE;
-    m += std::popcount(board.bitboards[BLACK_KNIGHT]) * KNIGHT_VALUE;
-    m += std::popcount(board.bitboards[BLACK_BISHOP]) * BISHOP_VALUE;
-    m += std::popcount(board.bitboards[BLACK_ROOK]) * ROOK_VALUE;
-    m += std::popcount(board.bitboards[BLACK_QUEEN]) * QUEEN_VALUE;
-    return m;
+    return material<PieceColor::BLACK>(board);
 }
 
-int openingSquareWeights(const Board &board)
+/**
+ * Sums the weights of the squares occupied by the pieces of a single kind
+ */
+int squareWeights(Bitboard pieces, const std::array<int, 64> &weights)
 {
     int eval = 0;
-
-    for (int i = 0; i < 64; i++)
+    while (pieces != 0)
     {
-        if (board[i].kind() == PieceKind::PAWN)
-        {
-            eval += board[i].color() == PieceColor::WHITE ? whitePawnOpeningWeights[i] : blackPawnOpeningWeights[i];
-        }
-        else if (board[i].kind() == PieceKind::KNIGHT)
-        {
-            eval += board[i].color() == PieceColor::WHITE ? whiteKnightOpeningWeights[i] : blackKnightOpeningWeights[i];
-        }
-        else if (board[i].kind() == PieceKind::KING)
-        {
-            eval += board[i].color() == PieceColor::WHITE ? whiteKingOpeningWeights[i] : blackKingOpeningWeights[i];
-        }
+        eval += weights[bitboards::popMSB(pieces)];
     }
+    return eval;
+}
 
+template <PieceColor Side>
+int openingSquareWeights(const Board &board)
+{
+    constexpr bool isWhite = Side == PieceColor::WHITE;
+    int eval = 0;
+    eval += squareWeights(board.bitboards[Piece{PieceKind::PAWN, Side}.index()],
+                          isWhite ? whitePawnOpeningWeights : blackPawnOpeningWeights);
+    eval += squareWeights(board.bitboards[Piece{PieceKind::KNIGHT, Side}.index()],
+                          isWhite ? whiteKnightOpeningWeights : blackKnightOpeningWeights);
+    eval += squareWeights(board.bitboards[Piece{PieceKind::KING, Side}.index()],
+                          isWhite ? whiteKingOpeningWeights : blackKingOpeningWeights);
     return eval;
 }
 
+int openingSquareWeights(const Board &board)
+{
+    return openingSquareWeights<PieceColor::WHITE>(board) + openingSquareWeights<PieceColor::BLACK>(board);
+}
+
 int endgameEval(const Board &board)
 {
     // TODO: Improve
@@ -139,8 +146,8 @@ int endgameEval(const Board &board)
 
     const bool whiteHasSlidingPieces = (board.bitboards[WHITE_ROOK] | board.bitboards[WHITE_BISHOP] | board.bitboards[WHITE_QUEEN]) != 0;
     const bool blackHasSlidingPieces = (board.bitboards[BLACK_ROOK] | board.bitboards[BLACK_BISHOP] | board.bitboards[BLACK_QUEEN]) != 0;
-    const int whiteKingPos = bitboards::getMSB(board.bitboards[WHITE_KING]);
-    const int blackKingPos = bitboards::getMSB(board.bitboards[BLACK_KING]);
+    const int whiteKingPos = board.getKingSquare(PieceColor::WHITE);
+    const int blackKingPos = board.getKingSquare(PieceColor::BLACK);
     const bool whiteIsWinning = whiteHasSlidingPieces && !blackHasSlidingPieces;
     const bool blackIsWinning = blackHasSlidingPieces && !whiteHasSlidingPieces;
 
@@ -168,6 +175,7 @@ double openingWeight(const Board &board)
     return std::max(totalMaterial / 1024 - 2, 0.0);
 }
 
+template <PieceColor Side>
 int staticEval(const Board &board)
 {
     int eval = 0;
@@ -176,9 +184,25 @@ int staticEval(const Board &board)
     eval += std::floor(static_cast<double>(openingSquareWeights(board)) * openingWeight(board));
     eval += std::floor(static_cast<double>(endgameEval(board)));
 
-    return eval * (board.sideToMove == PieceColor::WHITE ? 1 : -1);
+    if constexpr (Side == PieceColor::WHITE)
+    {
+        return eval;
+    }
+    else
+    {
+        return -eval;
+    }
+}
+
+int staticEval(const Board &board)
+{
+    return board.sideToMove == PieceColor::WHITE ? staticEval<PieceColor::WHITE>(board)
+                                                 : staticEval<PieceColor::BLACK>(board);
 }
 
+template int staticEval<PieceColor::WHITE>(const Board &board);
+template int staticEval<PieceColor::BLACK>(const Board &board);
+
 void printDebugEval(const Board &board)
 {
     std::cout << "Opening weight: " << openingWeight(board) << "\n";
@@ -12,6 +12,11 @@ constexpr int ROOK_VALUE = 500;
 constexpr int QUEEN_VALUE = 900;
 
 uint16_t pieceValue(PieceKind kind);
+/**
+ * Evaluates the position from the point of view of the side to move, which must be Side
+ */
+template <PieceColor Side>
+int staticEval(const Board &board);
 int staticEval(const Board &board);
 void printDebugEval(const Board &board);
 int whiteMaterial(const Board &board);
@@ -1,100 +1,331 @@
 #include "magic_searcher.hpp"
 #include "movegen.hpp"
+#include <algorithm>
+#include <bit>
+#include <format>
 #include <iostream>
+#include <limits>
+#include <numeric>
 #include <random>
-#include <unordered_set>
+#include <thread>
 
-static std::random_device randomDevice;
-static std::mt19937_64 rng{randomDevice()};
-static std::uniform_int_distribution<uint64_t> uniformIntDistribution{0, std::numeric_limits<uint64_t>::max()};
+#ifndef _WIN32
+#include <unistd.h>
+#endif
 
-Magics findMagics(size_t iterations, const std::vector<std::vector<uint64_t>> &blockerPositions)
+namespace
 {
-    Magics m{};
-    std::unordered_set<uint64_t> usedKeys;
-    for (int iter = 0; iter < iterations; iter++)
+// Tables that aren't found have this length, so that any magic is better
+constexpr uint32_t NO_TABLE = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Tries candidate magics for one square at a time. The table of the candidate being tried is kept between candidates,
+ * and each entry is stamped with the candidate that wrote it, so the table never has to be cleared.
+ */
+class MagicTrier
+{
+  public:
+    explicit MagicTrier(size_t maxTableLength) : stamps(maxTableLength), attacks(maxTableLength)
     {
-        for (int i = 0; i < 64; i++)
+    }
+
+    /**
+     * Returns the length of the table with this magic and shift, 0 if two blocker configurations with different
+     * attacks get the same index, or maxLength if the table would be at least that long
+     */
+    uint32_t tableLength(const MagicSquare &square, uint64_t magic, int shift, uint32_t maxLength)
+    {
+        nextStamp();
+        uint32_t length = 0;
+        for (size_t i = 0; i < square.blockers.size(); i++)
         {
-            usedKeys.clear();
-            const uint64_t magic = uniformIntDistribution(rng);
-            bool collision = false;
-            // shifts[i] is the best current value, so add 1 to search for a larger shift
-            const int newShift = m.shifts[i] + 1;
-            for (uint64_t blockers : blockerPositions[i])
+            const uint64_t index = square.blockers[i] * magic >> shift;
+            if (index + 1 >= maxLength)
+            {
+                return maxLength;
+            }
+            if (stamps[index] == stamp)
             {
-                uint64_t key = (blockers * magic) >> newShift;
-                if (usedKeys.contains(key))
+                if (attacks[index] != square.attacks[i])
                 {
-                    collision = true;
-                    break;
+                    return 0;
                 }
-                usedKeys.insert(key);
+                continue;
+            }
+            stamps[index] = stamp;
+            attacks[index] = square.attacks[i];
+            length = std::max(length, static_cast<uint32_t>(index + 1));
+        }
+        return length;
+    }
+
+  private:
+    std::vector<uint32_t> stamps;
+    std::vector<uint64_t> attacks;
+    uint32_t stamp = 0;
+
+    void nextStamp()
+    {
+        if (++stamp == 0)
+        {
+            // Stamps from before the wrap around could be mistaken for the current one
+            std::ranges::fill(stamps, 0);
+            stamp = 1;
+        }
+    }
+};
+
+/**
+ * Magics with few set bits are much more likely to work, because each blocker then only affects a few index bits
+ */
+uint64_t sparseRandom(std::mt19937_64 &generator)
+{
+    return generator() & generator() & generator();
+}
+
+/**
+ * Searches every square with its own random generator, keeping the shortest table found for each square
+ */
+Magics searchMagics(size_t iterations, const std::vector<MagicSquare> &squares, MagicLayout layout, int fixedShift)
+{
+    std::mt19937_64 generator{std::random_device{}()};
+    MagicTrier trier{static_cast<size_t>(1) << (64 - fixedShift)};
+    Magics m{};
+    for (int i = 0; i < 64; i++)
+    {
+        const MagicSquare &square = squares[i];
+        const uint64_t mask = std::reduce(square.blockers.begin(), square.blockers.end(), uint64_t{0}, std::bit_or{});
+        const int bits = std::popcount(mask);
+        const int minShift = layout == MagicLayout::FIXED_SHIFT ? fixedShift : 64 - bits;
+        const int maxShift = layout == MagicLayout::FIXED_SHIFT ? fixedShift : 63;
+        uint32_t bestLength = NO_TABLE;
+        for (size_t iter = 0; iter < iterations; iter++)
+        {
+            const uint64_t magic = sparseRandom(generator);
+            // The top bits of the index come from the top of the product, so a magic that puts few of the mask's bits
+            // there can't map the blockers to distinct indexes
+            if (std::popcount((mask * magic) & 0xFF00000000000000) < 6)
+            {
+                continue;
             }
-            if (!collision)
+            for (int shift = minShift; shift <= maxShift; shift++)
             {
-                m.magics[i] = magic;
-                m.shifts[i] = newShift;
+                const uint32_t length = trier.tableLength(square, magic, shift, bestLength);
+                if (length == 0)
+                {
+                    // Indexes that are the same with this shift are also the same with any larger shift
+                    break;
+                }
+                if (length < bestLength)
+                {
+                    bestLength = length;
+                    m.magics[i] = magic;
+                    m.shifts[i] = shift;
+                    m.lengths[i] = length;
+                }
             }
         }
     }
     return m;
 }
 
-void printMagics(Magics m, std::string pieceName)
+/**
+ * Size in bytes of the level 1 data cache or the level 2 cache, or the fallback if the system doesn't report it
+ */
+size_t cacheSize(int level, size_t fallback)
 {
-    std::string magicsOutput;
-    magicsOutput += "constexpr array<uint64_t, 64> " + pieceName + "_MAGICS{";
-    for (int i = 0; i < 64; i++)
+#if defined(_SC_LEVEL1_DCACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+    const long size = sysconf(level == 1 ? _SC_LEVEL1_DCACHE_SIZE : _SC_LEVEL2_CACHE_SIZE);
+    if (size > 0)
+    {
+        return static_cast<size_t>(size);
+    }
+#endif
+    return fallback;
+}
+
+std::string cacheFit(size_t bytes)
+{
+    const size_t l1 = cacheSize(1, 32 * 1024);
+    const size_t l2 = cacheSize(2, 1024 * 1024);
+    const std::string sizes = std::format("L1d {} KiB, L2 {} KiB", l1 / 1024, l2 / 1024);
+    if (bytes <= l1)
+    {
+        return "fits in L1 (" + sizes + ")";
+    }
+    if (bytes <= l2)
+    {
+        return std::format("fits in L2, {:.1f}x L1 ({})", static_cast<double>(bytes) / l1, sizes);
+    }
+    return std::format("{:.1f}x L2 ({})", static_cast<double>(bytes) / l2, sizes);
+}
+
+/**
+ * Formats an array constant in the style of movegen.cpp, wrapping the values at 120 columns
+ */
+std::string arrayConstant(const std::string &name, const std::vector<std::string> &values)
+{
+    std::string output = "constexpr array<uint64_t, 64> " + name + "{\n";
+    std::string line = "   ";
+    for (size_t i = 0; i < values.size(); i++)
     {
-        magicsOutput += std::format("0x{:x}", m.magics[i]);
-        if (i != 63)
+        const std::string value = " " + values[i] + (i + 1 == values.size() ? "};" : ",");
+        if (line.size() + value.size() > 120)
         {
-            magicsOutput += ", ";
+            output += line + "\n";
+            line = "   ";
         }
+        line += value;
     }
-    magicsOutput += "};";
-    std::string shiftsOutput;
-    shiftsOutput += "constexpr array<uint64_t, 64> " + pieceName + "_SHIFTS{";
-    for (int i = 0; i < 64; i++)
+    return output + line + "\n";
+}
+
+std::vector<MagicSquare> magicSquares(const std::array<Bitboard, 64> &blockerMasks,
+                                      Bitboard (*attacks)(Square, Bitboard))
+{
+    std::vector<MagicSquare> squares(64);
+    for (Square i = 0; i < 64; i++)
     {
-        shiftsOutput += std::to_string(m.shifts[i]);
-        if (i != 63)
+        squares[i].blockers = movegen::possibleBlockerPositions(blockerMasks[i]);
+        for (Bitboard blockers : squares[i].blockers)
         {
-            shiftsOutput += ", ";
+            squares[i].attacks.push_back(attacks(i, blockers));
         }
     }
-    shiftsOutput += "};";
+    return squares;
+}
 
-    std::cout << magicsOutput << "\n";
-    std::cout << shiftsOutput << "\n";
+void findSliderMagics(size_t iterations, MagicLayout layout, unsigned int threadCount,
+                      const std::vector<MagicSquare> &squares, const std::string &pieceName)
+{
+    const Magics m = findMagics(iterations, squares, layout, threadCount);
+    printMagics(m, squares, pieceName);
+}
+} // namespace
 
-    int totalBits = 0;
-    for (int i = 0; i < 64; i++)
+Magics findMagics(size_t iterations, const std::vector<MagicSquare> &squares, MagicLayout layout,
+                  unsigned int threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    // With a fixed shift, every square gets the index bits of the square with the most blocker configurations
+    size_t maxConfigurations = 0;
+    for (const MagicSquare &square : squares)
+    {
+        maxConfigurations = std::max(maxConfigurations, square.blockers.size());
+    }
+    const int fixedShift = 64 - std::countr_zero(maxConfigurations);
+    const size_t iterationsPerThread = (iterations + threadCount - 1) / threadCount;
+
+    std::vector<Magics> results(threadCount);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([&, i]
+                             { results[i] = searchMagics(iterationsPerThread, squares, layout, fixedShift); });
+    }
+    for (std::thread &thread : threads)
     {
-        totalBits += 64 - m.shifts[i];
+        thread.join();
+    }
+
+    Magics best = results[0];
+    for (const Magics &result : results)
+    {
+        for (int i = 0; i < 64; i++)
+        {
+            if (result.lengths[i] != 0 && (best.lengths[i] == 0 || result.lengths[i] < best.lengths[i]))
+            {
+                best.magics[i] = result.magics[i];
+                best.shifts[i] = result.shifts[i];
+                best.lengths[i] = result.lengths[i];
+            }
+        }
     }
-    std::cout << "\nTotal size: " << totalBits << " bits \n\n";
+    return best;
 }
 
-void findRookMagics(size_t iterations)
+size_t overlappingTableLength(const Magics &m, const std::vector<MagicSquare> &squares)
 {
-    std::vector<std::vector<uint64_t>> blockerPositions;
-    for (int i = 0; i < 64; i++)
+    // Slider attacks are never empty, so empty entries are unused
+    std::vector<uint64_t> table;
+    std::vector<int> order(64);
+    std::iota(order.begin(), order.end(), 0);
+    // Large tables are placed first, so that small ones can fill the gaps between them
+    std::ranges::stable_sort(order, std::greater{}, [&](int i)
+                             { return m.lengths[i]; });
+
+    size_t tableLength = 0;
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    for (const int i : order)
     {
-        blockerPositions.push_back(movegen::possibleBlockerPositions(movegen::getRookBlockerMasks()[i]));
+        if (m.lengths[i] == 0)
+        {
+            continue;
+        }
+        entries.clear();
+        for (size_t j = 0; j < squares[i].blockers.size(); j++)
+        {
+            entries.emplace_back(squares[i].blockers[j] * m.magics[i] >> m.shifts[i], squares[i].attacks[j]);
+        }
+        size_t offset = 0;
+        while (!std::ranges::all_of(entries, [&](const std::pair<uint64_t, uint64_t> &entry)
+                                    {
+                                        const size_t index = offset + entry.first;
+                                        return index >= table.size() || table[index] == 0 ||
+                                               table[index] == entry.second;
+                                    }))
+        {
+            offset++;
+        }
+        table.resize(std::max<size_t>(table.size(), offset + m.lengths[i]));
+        for (const auto &[index, attacks] : entries)
+        {
+            table[offset + index] = attacks;
+        }
+        tableLength = std::max<size_t>(tableLength, offset + m.lengths[i]);
     }
-    Magics m = findMagics(iterations, blockerPositions);
-    printMagics(m, "ROOK");
+    return tableLength;
 }
 
-void findBishopMagics(size_t iterations)
+void printMagics(const Magics &m, const std::vector<MagicSquare> &squares, const std::string &pieceName)
 {
-    std::vector<std::vector<uint64_t>> blockerPositions;
+    std::vector<std::string> magics;
+    std::vector<std::string> shifts;
+    int missing = 0;
+    size_t packedLength = 0;
     for (int i = 0; i < 64; i++)
     {
-        blockerPositions.push_back(movegen::possibleBlockerPositions(movegen::getBishopBlockerMasks()[i]));
+        magics.push_back(std::format("0x{:x}", m.magics[i]));
+        shifts.push_back(std::to_string(m.shifts[i]));
+        packedLength += m.lengths[i];
+        missing += m.lengths[i] == 0;
+    }
+    std::cout << arrayConstant(pieceName + "_MAGICS", magics);
+    std::cout << arrayConstant(pieceName + "_SHIFTS", shifts) << "\n";
+    if (missing != 0)
+    {
+        std::cout << "No magic was found for " << missing << " squares, try more iterations\n\n";
+        return;
     }
-    Magics m = findMagics(iterations, blockerPositions);
-    printMagics(m, "BISHOP");
+
+    const size_t overlappingLength = overlappingTableLength(m, squares);
+    const size_t packedBytes = packedLength * sizeof(Bitboard);
+    const size_t overlappingBytes = overlappingLength * sizeof(Bitboard);
+    std::cout << std::format("Table: {} entries ({:.1f} KiB), {}\n", packedLength, packedBytes / 1024.0,
+                             cacheFit(packedBytes));
+    std::cout << std::format("Overlapping tables: {} entries ({:.1f} KiB), {}\n\n", overlappingLength,
+                             overlappingBytes / 1024.0, cacheFit(overlappingBytes));
+}
+
+void findRookMagics(size_t iterations, MagicLayout layout, unsigned int threadCount)
+{
+    findSliderMagics(iterations, layout, threadCount, magicSquares(movegen::getRookBlockerMasks(), movegen::rookAttacks<>),
+                     "ROOK");
+}
+
+void findBishopMagics(size_t iterations, MagicLayout layout, unsigned int threadCount)
+{
+    findSliderMagics(iterations, layout, threadCount,
+                     magicSquares(movegen::getBishopBlockerMasks(), movegen::bishopAttacks<>), "BISHOP");
 }
@@ -1,24 +1,61 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
+/**
+ * How the attack tables of the 64 squares of a piece are laid out, which decides which magics are best
+ */
+enum class MagicLayout
+{
+    // Each square has its own shift, and the tables are stored one after another (the layout used by movegen)
+    PACKED,
+    // Every square of a piece uses the same shift, so the shift doesn't need to be loaded for each lookup
+    FIXED_SHIFT
+};
+
 struct Magics
 {
     std::array<uint64_t, 64> magics{};
     std::array<int, 64> shifts{};
+    // Length of the table of each square (one more than the largest index), or 0 if no magic was found
+    std::array<uint32_t, 64> lengths{};
 };
 
 /**
- * For each square, find a unique magic and shift value that allows for a unique mapping between the 64-bit bitboard
- * and a smaller value, which can be used as an array index in an array of attacking squares. The aim is to maximise
- * the shift in order to minimise the range of indexes and hence the array size.
+ * Every blocker configuration of a square and the attacks with those blockers, at the same indices
  */
-Magics findMagics(size_t iterations, const std::vector<std::vector<uint64_t>> &blockerPositions);
+struct MagicSquare
+{
+    std::vector<uint64_t> blockers;
+    std::vector<uint64_t> attacks;
+};
 
-void printMagics(Magics m, std::string pieceName);
+/**
+ * For each square, find a magic and shift which map every blocker configuration to an index in the square's attack
+ * table. Two configurations can share an index if they have the same attacks. The aim is to minimise the length of
+ * each table (the largest index used plus one), which with per-square shifts can be less than 2^(64 - shift).
+ *
+ * Each thread tries the given number of candidates per square divided by the thread count, and the best magic of each
+ * square is kept.
+ */
+Magics findMagics(size_t iterations, const std::vector<MagicSquare> &squares, MagicLayout layout,
+                  unsigned int threadCount);
+
+/**
+ * Total number of table entries if the tables of different squares may overlap, with entries that would be unused in
+ * one table holding the attacks of another. The tables are placed at the first offset where they don't conflict.
+ */
+size_t overlappingTableLength(const Magics &m, const std::vector<MagicSquare> &squares);
+
+/**
+ * Prints the magics and shifts as constants that can be pasted into movegen.cpp, followed by the size of the table
+ */
+void printMagics(const Magics &m, const std::vector<MagicSquare> &squares, const std::string &pieceName);
 
-void findRookMagics(size_t iterations);
+void findRookMagics(size_t iterations, MagicLayout layout, unsigned int threadCount);
 
-void findBishopMagics(size_t iterations);
\ No newline at end of file
+void findBishopMagics(size_t iterations, MagicLayout layout, unsigned int threadCount);
@@ -1,4 +1,5 @@
 #include "Board.hpp"
+#include "bench.hpp"
 #include "eval.hpp"
 #include "magic_searcher.hpp"
 #include "search.hpp"
@@ -21,8 +22,29 @@ int main()
     while (true)
     {
         string command;
-        cin >> command;
-        if (command == "position")
+        if (!(cin >> command))
+        {
+            // End of input, for example when the commands are piped in
+            break;
+        }
+        if (command == "uci")
+        {
+            // Flushed, because GUIs wait for these replies before sending anything else
+            cout << "id name chess_cpp\n";
+            cout << "uciok" << std::endl;
+        }
+        else if (command == "isready")
+        {
+            // Everything else is already in the binary, so only the transposition table is left to set up
+            allocateTranspositionTable();
+            cout << "readyok" << std::endl;
+        }
+        else if (command == "ucinewgame")
+        {
+            clearTranspositionTable();
+            resetSearchState();
+        }
+        else if (command == "position")
         {
             string mode;
             std::cin >> mode;
@@ -102,9 +124,26 @@ int main()
             }
             else if (mode == "perft")
             {
+                // go perft <depth> [threads <n>] [hash <MB>]
                 int depth;
                 cin >> depth;
-                runPerft(depth, board.getFen());
+                string options;
+                std::getline(cin, options);
+                const std::vector<string> tokens = splitString(options, " ");
+                unsigned int threadCount = 1;
+                size_t cacheSizeMB = 0;
+                for (size_t i = 0; i + 1 < tokens.size(); i++)
+                {
+                    if (tokens[i] == "threads")
+                    {
+                        threadCount = std::stoi(tokens[i + 1]);
+                    }
+                    else if (tokens[i] == "hash")
+                    {
+                        cacheSizeMB = std::stoull(tokens[i + 1]);
+                    }
+                }
+                runPerft(depth, board.getFen(), threadCount, cacheSizeMB);
             }
         }
         else if (command == "d")
@@ -119,12 +158,33 @@ int main()
         {
             runTests();
         }
+        else if (command == "bench")
+        {
+            runBenchmarks();
+        }
         else if (command == "magics")
         {
-            int iterations;
-            std::cin >> iterations;
-            findRookMagics(iterations);
-            findBishopMagics(iterations);
+            // magics <iterations per square> [threads <n>] [fixed]
+            size_t iterations;
+            cin >> iterations;
+            string options;
+            std::getline(cin, options);
+            unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+            MagicLayout layout = MagicLayout::PACKED;
+            const std::vector<string> tokens = splitString(options, " ");
+            for (size_t i = 0; i < tokens.size(); i++)
+            {
+                if (tokens[i] == "threads" && i + 1 < tokens.size())
+                {
+                    threadCount = std::stoi(tokens[++i]);
+                }
+                else if (tokens[i] == "fixed")
+                {
+                    layout = MagicLayout::FIXED_SHIFT;
+                }
+            }
+            findRookMagics(iterations, layout, threadCount);
+            findBishopMagics(iterations, layout, threadCount);
         }
         else if (command == "quit")
         {
@@ -11,8 +11,14 @@
 
 using node_hashmap_t = std::unordered_map<uint64_t, MctsNodeStats>;
 
-std::random_device randomDevice;
-std::mt19937 rng(randomDevice());
+/**
+ * Seeded on first use instead of at startup, since most runs of the engine never use MCTS
+ */
+std::mt19937 &rng()
+{
+    static std::mt19937 generator{std::random_device{}()};
+    return generator;
+}
 
 node_hashmap_t whiteNodes;
 node_hashmap_t blackNodes;
@@ -25,7 +31,7 @@ node_hashmap_t& getNodes(PieceColor color)
 int randint(int min, int max)
 {
     std::uniform_int_distribution uniformIntDistribution{min, max};
-    return uniformIntDistribution(rng);
+    return uniformIntDistribution(rng());
 }
 
 Move randomMove(const MoveList& moves)
@@ -69,10 +75,10 @@ struct MoveProbability
 Move randomMoveFromDistribution(std::vector<MoveProbability> probabilities)
 {
     // Shuffle first to make selection between identical probabilities random
-    std::ranges::shuffle(probabilities, rng);
+    std::ranges::shuffle(probabilities, rng());
     std::ranges::sort(probabilities);
     std::uniform_real_distribution<> distribution{0, 1};
-    double sample = distribution(rng);
+    double sample = distribution(rng());
     for (int i = 0; i < probabilities.size(); i++)
     {
         if (sample < probabilities[i].probability)
@@ -101,22 +107,24 @@ void MctsNodeStats::update(GameResult gameResult)
     }
 }
 
-GameResult rollout(Board board)
+GameResult rollout(const Board &board)
 {
-    MoveList moves = board.getLegalMoves();
-    while (!moves.empty() && !board.isDraw())
+    // Rollouts never need to unmake moves, so copy-make on a Position is used instead of copying the whole board
+    Position position = board;
+    PositionHistory history = board.getPositionHistory();
+    MoveList moves = position.getLegalMoves();
+    TerminalStatus status = position.terminalStatus(moves);
+    while (status == TerminalStatus::NONE && !history.isThreefoldRepetition(position.getHalfMoveClock()))
     {
-        board.makeMove(randomMove(moves));
-        moves = board.getLegalMoves();
+        position.makeMove(randomMove(moves));
+        history.push(position.getHash());
+        moves = position.getLegalMoves();
+        status = position.terminalStatus(moves);
     }
 
-    if (board.isCheckmate(PieceColor::WHITE))
-    {
-        return GameResult::BLACK_WON;
-    }
-    if (board.isCheckmate(PieceColor::BLACK))
+    if (status == TerminalStatus::CHECKMATE)
     {
-        return GameResult::WHITE_WON;
+        return position.sideToMove == PieceColor::WHITE ? GameResult::BLACK_WON : GameResult::WHITE_WON;
     }
     return GameResult::DRAW;
 }
@@ -143,7 +151,7 @@ GameResult mctsIteration(Board& board, const PieceColor side)
 
     MoveList moves = board.getLegalMoves();
     // rollout() will handle the case when the game has ended by simply returning the game result with no iterations
-    if (!nodes.contains(currentHash) || moves.empty() || board.isDraw())
+    if (!nodes.contains(currentHash) || board.terminalStatus(moves) != TerminalStatus::NONE)
     {
         auto result = rollout(board);
         nodes[currentHash].update(result); // TODO: Problem might be here?
@@ -1,7 +1,13 @@
 #include "movegen.hpp"
-#include "Board.hpp"
+#include "Position.hpp"
 #include "bitboards.hpp"
+#include <algorithm>
 #include <bit>
+#include <stdexcept>
+
+#if defined(__BMI2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 using std::vector, std::array;
 using enum PieceColor;
@@ -71,7 +77,7 @@ constexpr uint8_t edgeDistanceInDirection(Square square, Direction direction)
     std::unreachable();
 }
 
-constexpr Bitboard rayAttackingSquares(Bitboard blockers, Square position, const vector<Direction> &directions)
+constexpr Bitboard rayAttackingSquares(Bitboard blockers, Square position, std::initializer_list<Direction> directions)
 {
     Bitboard attackingSquares = 0;
 
@@ -183,9 +189,9 @@ constexpr array<array<RayFromSquare, 8>, 64> precomputeSquareRays()
     return rays;
 }
 
-const auto SQUARE_RAYS = precomputeSquareRays();
+constexpr auto SQUARE_RAYS = precomputeSquareRays();
 
-array<array<Bitboard, 64>, 64> computeSquaresBetweenSquares()
+constexpr array<array<Bitboard, 64>, 64> computeSquaresBetweenSquares()
 {
     array<array<Bitboard, 64>, 64> s{};
     for (Square i = 0; i < 64; i++)
@@ -208,7 +214,36 @@ array<array<Bitboard, 64>, 64> computeSquaresBetweenSquares()
     return s;
 }
 
-const array<array<Bitboard, 64>, 64> squaresBetweenSquares = computeSquaresBetweenSquares();
+constexpr array<array<Bitboard, 64>, 64> squaresBetweenSquares = computeSquaresBetweenSquares();
+
+constexpr array<array<Bitboard, 64>, 64> computeLinesThroughSquares()
+{
+    array<array<Bitboard, 64>, 64> lines{};
+    for (Square i = 0; i < 64; i++)
+    {
+        for (const auto [rayBitboard, direction] : SQUARE_RAYS[i])
+        {
+            // The line extends from one edge of the board to the other, so it also includes the opposite ray
+            Bitboard line = rayBitboard | bitboards::withSquare(i);
+            for (const auto [oppositeRayBitboard, oppositeDirection] : SQUARE_RAYS[i])
+            {
+                if (static_cast<int8_t>(oppositeDirection) == -static_cast<int8_t>(direction))
+                {
+                    line |= oppositeRayBitboard;
+                }
+            }
+            Bitboard squaresOnRay = rayBitboard;
+            while (squaresOnRay != 0)
+            {
+                lines[i][bitboards::popMSB(squaresOnRay)] = line;
+            }
+        }
+    }
+    return lines;
+}
+
+// Squares on the line through two squares on the same rank, file or diagonal, including the squares themselves
+constexpr array<array<Bitboard, 64>, 64> lineThroughSquares = computeLinesThroughSquares();
 
 vector<Bitboard> possibleBlockerPositions(Bitboard blockerMask)
 {
@@ -243,44 +278,41 @@ vector<Bitboard> possibleBlockerPositions(Bitboard blockerMask)
 }
 
 constexpr array<uint64_t, 64> ROOK_MAGICS{
-    0xe7ab6c0052e686be, 0x14087c57effa2114, 0x9a789e001704734e, 0xc1289dffdaf1f9ee, 0x7f30e5fff60cacce,
-    0x389f1339a5c1d9f2, 0xccc6afd1ffed5a56, 0xf9f4de4121b50082, 0xf703530ca9440200, 0x5451028464f1c00,
-    0x146926f02333020, 0x1de0682c5de44bb4, 0x53c44ca53b3ffbc8, 0x75d17116b393dce7, 0x420a483a1011483c,
-    0x504e20b1235f7418, 0x2d3a8407814e0011, 0xbcea30087204004f, 0xfbfe0b7023bfd448, 0x7c597408a4300118,
-    0xdf6bd66fd7a77aad, 0x71ec963e5034152f, 0xaab1beeb167c2ee1, 0x959cfcfcb06ff9ff, 0xa1efe6a1b470a33e,
-    0x46788c2411000ea2, 0xe181860941861e6e, 0x2a50d993366ca4bf, 0xab177c0005a5a72d, 0x606658f9e8f547b3,
-    0xcf0c96cf5b5de517, 0x36ac6caf5cd7fdaf, 0x779d5ff5fd0134c9, 0xcfeedc6af2073398, 0x94d8200440150426,
-    0xa70cdbd37373759d, 0xc180c5e0c5828ea7, 0x2db7729c47680043, 0x18e4424791d4540, 0x536ae2b28f5b2e04,
-    0x53eb0f488c94a5a2, 0xc94e554fd5335613, 0x26ba46ab90f23543, 0x94684d970e376eb3, 0x45448c2e80106a17,
-    0xde0850180478aee7, 0xdbe5f061f0dab6f1, 0xaf9aed4bf7af67c2, 0x4a28180ea295b306, 0x75308266af7918f9,
-    0x49f30390d1387303, 0x9278ca1e302e18ca, 0xe3006f606fd7d14f, 0x67881683707d30e5, 0x1a3ae0f34e13dc3f,
-    0x81eb3e9f45ee2418, 0x4d990672c598c195, 0xc0044c7fc09f0007, 0x13e1f731196ffa22, 0xd5a20cbca7067bc4,
-    0x1b139d8d4539b139, 0xde87571a5615ade, 0xff6fe8ffc19e2a91, 0x6905474a0c1585};
+    0x100048407250842, 0x600880110008204, 0xe045000400020801, 0x8492001020080402, 0x2010002004081101,
+    0x1014081040820222, 0x4240004021001081, 0x800020104101, 0x40c8104245200, 0x5401001200040500, 0x40080020080,
+    0x24c000800048080, 0x100008008080, 0x10e00813220c200, 0x2200200440008480, 0x8704000800180, 0x800000a049020004,
+    0x1001000200010004, 0xa040002008080, 0x28040008008080, 0x1008008010008008, 0x180408200220012, 0x1410004020094000,
+    0x400080208002, 0x8804402000081, 0x9000821004008108, 0x882800200800401, 0x54a0040080800800, 0x5200100021000900,
+    0x2006100088802001, 0x50400080802000, 0x2001400586800023, 0x40100c0200008069, 0x2004280400020190, 0x204020080040080,
+    0x4008080040800, 0x808100080080080, 0x2100200100410010, 0x10350242002a0080, 0x30902080004000, 0x182020004288051,
+    0xa1084003810410a, 0x200680130042040, 0x482850008010011, 0xa0808008001004, 0x8000808020001000, 0x40028020024080,
+    0x2200808000400020, 0x1322802041000480, 0x848800200800100, 0x8000808004000200, 0x4210800800c40080,
+    0x2071002010000d00, 0x8082802000100080, 0xa464402010054001, 0x4800080400824, 0x8011c220800100, 0x480010002000880,
+    0x3880118004003200, 0x200020008102004, 0x1800c3000080080, 0x100081020004100, 0x21400090002000c2,
+    0x2080074000102080};
 constexpr array<uint64_t, 64> ROOK_SHIFTS{
-    52, 52, 52, 52, 52, 52, 52, 51, 53, 54, 53, 53, 53, 53, 53, 52, 53, 54, 52, 53, 53, 53, 53, 52, 52, 53, 53, 53,
-    53, 53, 53, 52, 52, 53, 53, 53, 53, 53, 53, 52, 52, 53, 53, 52, 53, 53, 53, 52, 52, 53, 53, 53, 53, 53, 53, 52,
-    51, 52, 51, 51, 52, 51, 51, 50};
+    52, 53, 53, 53, 53, 53, 53, 52, 53, 54, 54, 54, 54, 54, 54, 53, 53, 54, 54, 54, 54, 54, 54, 53, 53, 54, 54, 54, 54,
+    54, 54, 53, 53, 54, 54, 54, 54, 54, 54, 53, 53, 54, 54, 54, 54, 54, 54, 53, 53, 54, 54, 54, 54, 54, 54, 53, 52, 53,
+    53, 53, 53, 53, 53, 52};
 
 constexpr array<uint64_t, 64> BISHOP_MAGICS{
-    0x85380e2c592c4fa1, 0x11182de0338c6980, 0xd6868fee200816cf, 0xbfa5e4050120619, 0x186ca2437de19811,
-    0x691909c291480803, 0x2279d6ef2b10171c, 0x11e4fa7048d410c8, 0x76b5500a1a01a033, 0x4c303010009fa349,
-    0x7f5700ab0310263, 0x754305ec8504003f, 0x626b3c21e0982c0d, 0x56436a02ccb5cf47, 0xf341074f04203fb7,
-    0xe80b83a808c02b97, 0xe7680a9c06427781, 0xd7c8c258bdfba3f4, 0xa64522de33d187a3, 0xf0540a0d9543255c,
-    0x8ed13334d81069a0, 0xa629c2034047c404, 0x6fb5b52d36e52003, 0x3538024650f9e07e, 0x1e38034380c30b8a,
-    0x525280b098b9420, 0xf6ee878303ae0105, 0x24e2b7c812543d07, 0xb6ce1af139079792, 0xee8c00609f31f031,
-    0xa461286012880d0d, 0x8368844002a42823, 0xea02328aa600865c, 0x1b7bf8eab2b7e9ac, 0x99010a0085005d0d,
-    0x58da7050f7d6cb66, 0x4a1853a2e747ae89, 0x9d38a6033904f141, 0x85b8242fce304e0a, 0x94d04009901c13aa,
-    0x107e16f396062a27, 0x7fc1024c088854bd, 0x8bfe3d8c62b2074f, 0x239d829c00a056b8, 0x9d369feb48b26a94,
-    0xeec7fdeff5770c70, 0x85094c1218080087, 0x61c032dc08c80706, 0x56467c84041f2444, 0x72d6d20822221121,
-    0xec34ee059b2232a2, 0x98300910c1069902, 0x40d21816084174f5, 0xefde98298c1387ce, 0xb4c1cc8428124f01,
-    0x8d5db872b0620202, 0x5b4f9027194cccb0, 0x4a9c0509b03038e6, 0xe24e033ca04efc19, 0x61d40ce056a552a2,
-    0xb2bc241386917c17, 0x81902588910bf33f, 0x6a045c4c034a077a, 0x40a104f4db56b65c};
+    0x4400202006134c8, 0x22022129400c422, 0xc880824005080220, 0x4000020c12602200, 0x4001a004002a0800,
+    0x421000004062c4b0, 0x6020108a84408, 0xc04420804010400, 0x4806028304203c40, 0xc050650c40200, 0x48200242021200,
+    0x1ad021024000, 0x2800009610440081, 0x200412a38d009d0, 0x231220602204000, 0x903a108420080901, 0x5042808409003080,
+    0x2144088c800200, 0x8004102042000444, 0x20401081200a01, 0x4400201100080c, 0x101090013804, 0xa221840da0000800,
+    0x501282240c008, 0x1182040900005040, 0x204010409004408, 0x20508080a50800, 0x1050400020220, 0x4008020080280082,
+    0x10405020e0800, 0x4040200200278, 0x410021120200409, 0x802128202024106, 0x1070604048840, 0x20411000c900084,
+    0x800404014010040, 0x8002080004040408, 0x1208180004002020, 0x412090030100090, 0x1840108a108900, 0x2801208104094400,
+    0xa18200186151a402, 0x2621008200808400, 0x2000c20210200, 0x20c002801481000, 0x820805001001020, 0x422000888090405,
+    0x401000442108010a, 0x8010d3b22020300, 0x44001122c1a00880, 0x180e08820090408, 0x88142021000000a, 0x24b11444018020a0,
+    0x4400101420404000, 0x10204100222042c, 0x46250200ca08, 0x20081c8301430c05, 0x28948e0240100, 0x5242060014001,
+    0x44042014002080, 0x80a8224042070000, 0x1010041092202814, 0x802186821104010, 0x28988023c0140};
 constexpr array<uint64_t, 64> BISHOP_SHIFTS{
-    57, 59, 59, 59, 59, 59, 59, 57, 59, 59, 59, 59, 59, 59, 59, 59, 59, 59, 56, 56, 56, 57, 59, 59, 59, 59, 57, 53,
-    53, 56, 59, 59, 59, 59, 57, 53, 54, 56, 59, 59, 59, 59, 56, 57, 56, 56, 59, 59, 59, 59, 59, 59, 59, 59, 59, 59,
-    57, 59, 59, 59, 59, 59, 59, 57};
+    58, 59, 59, 59, 59, 59, 59, 58, 59, 59, 59, 59, 59, 59, 59, 59, 59, 59, 57, 57, 57, 57, 59, 59, 59, 59, 57, 55, 55,
+    57, 59, 59, 59, 59, 57, 55, 55, 57, 59, 59, 59, 59, 57, 57, 57, 57, 59, 59, 59, 59, 59, 59, 59, 59, 59, 59, 58, 59,
+    59, 59, 59, 59, 59, 58};
 
-array<Bitboard, 64> ROOK_BLOCKER_MASKS = []
+constexpr array<Bitboard, 64> ROOK_BLOCKER_MASKS = []
 {
     array<Bitboard, 64> masks{};
     for (int rookIndex = 0; rookIndex < 64; rookIndex++)
@@ -309,7 +341,7 @@ array<Bitboard, 64> ROOK_BLOCKER_MASKS = []
     return masks;
 }();
 
-array<Bitboard, 64> BISHOP_BLOCKER_MASKS = []
+constexpr array<Bitboard, 64> BISHOP_BLOCKER_MASKS = []
 {
     array<Bitboard, 64> masks{};
     for (int bishopIndex = 0; bishopIndex < 64; bishopIndex++)
@@ -333,128 +365,173 @@ array<Bitboard, 64> BISHOP_BLOCKER_MASKS = []
     return masks;
 }();
 
-// TODO: Use consteval for magic bitboard functions that can run at compile time
-array<vector<Bitboard>, 64> computeRookAttackingSquares()
+// Magic indexes have 64 - shift bits, so the table never needs more entries than this for each piece
+constexpr size_t maxSliderTableSize(const array<uint64_t, 64> &shifts)
 {
-    array<vector<Bitboard>, 64> attackingSquares{};
-
-    for (Square i = 0; i < 64; i++)
+    size_t size = 0;
+    for (const uint64_t shift : shifts)
     {
-        uint64_t arrayLength = 0;
-        for (const Bitboard blockerMask : possibleBlockerPositions(ROOK_BLOCKER_MASKS[i]))
-        {
-            arrayLength = std::max(arrayLength, blockerMask * ROOK_MAGICS[i] >> ROOK_SHIFTS[i]);
-        }
-        // Add 1 because the array length will be one more than the maximum index
-        arrayLength++;
+        size += static_cast<size_t>(1) << (64 - shift);
+    }
+    return size;
+}
 
-        attackingSquares[i].resize(arrayLength);
-        for (const Bitboard blockerPositions : possibleBlockerPositions(ROOK_BLOCKER_MASKS[i]))
+/**
+ * Same as the BMI2 PEXT instruction, for building the PEXT table at compile time
+ */
+constexpr uint64_t softwarePext(uint64_t value, uint64_t mask)
+{
+    uint64_t result = 0;
+    for (uint64_t bit = 1; mask != 0; bit <<= 1)
+    {
+        if ((value & mask & -mask) != 0)
         {
-            const uint32_t index = blockerPositions * ROOK_MAGICS[i] >> ROOK_SHIFTS[i];
-            attackingSquares[i][index] = rayAttackingSquares(blockerPositions, i, {Direction::NORTH, Direction::SOUTH, Direction::WEST, Direction::EAST});
+            result |= bit;
         }
+        mask &= mask - 1;
     }
-
-    return attackingSquares;
+    return result;
 }
 
-// TODO: Merge with rook attacking squares
-array<vector<Bitboard>, 64> computeBishopAttackingSquares()
+/**
+ * Attacks of rooks and bishops on every square for every blocker configuration, stored in a single contiguous, cache
+ * aligned table instead of one allocation per square. Each square has an offset into the table, and the blockers are
+ * turned into an index from that offset either with the magic multiplication or, on CPUs with BMI2, with PEXT, which
+ * extracts the blocker bits under the mask into a dense index and so doesn't need any magics. The tables are built at
+ * compile time and stored in the binary.
+ */
+template <SliderIndexing Indexing>
+class SliderAttackTable
 {
-    array<vector<Bitboard>, 64> attackingSquares{};
+  public:
+    constexpr SliderAttackTable()
+    {
+        using enum Direction;
+        size_t offset = 0;
+        offset = addSquares(rookSquares, ROOK_BLOCKER_MASKS, ROOK_MAGICS, ROOK_SHIFTS, {NORTH, SOUTH, WEST, EAST}, offset);
+        addSquares(bishopSquares, BISHOP_BLOCKER_MASKS, BISHOP_MAGICS, BISHOP_SHIFTS, {NORTHWEST, NORTHEAST, SOUTHWEST, SOUTHEAST}, offset);
+    }
 
-    for (Square i = 0; i < 64; i++)
+    constexpr Bitboard rookAttacks(Square square, Bitboard occupancy) const
+    {
+        return attacks[rookSquares[square].offset + index(rookSquares[square], occupancy)];
+    }
+
+    constexpr Bitboard bishopAttacks(Square square, Bitboard occupancy) const
+    {
+        return attacks[bishopSquares[square].offset + index(bishopSquares[square], occupancy)];
+    }
+
+  private:
+    // Everything needed to find the attacks of a square, which is half of a cache line
+    struct SquareEntry
+    {
+        Bitboard mask;
+        uint64_t magic;
+        uint32_t offset;
+        uint8_t shift;
+    };
+
+    static constexpr uint64_t index(const SquareEntry &entry, Bitboard occupancy)
     {
-        uint64_t arrayLength = 0;
-        for (const Bitboard blockerMask : possibleBlockerPositions(BISHOP_BLOCKER_MASKS[i]))
+        if constexpr (Indexing == SliderIndexing::PEXT)
         {
-            arrayLength = std::max(arrayLength, blockerMask * BISHOP_MAGICS[i] >> BISHOP_SHIFTS[i]);
+            if consteval
+            {
+                return softwarePext(occupancy, entry.mask);
+            }
+            else
+            {
+#ifdef __BMI2__
+                return _pext_u64(occupancy, entry.mask);
+#endif
+            }
         }
-        // Add 1 because the array length will be one more than the maximum index
-        arrayLength++;
+        return (occupancy & entry.mask) * entry.magic >> entry.shift;
+    }
 
-        attackingSquares[i].resize(arrayLength);
-        for (const Bitboard blockerPositions : possibleBlockerPositions(BISHOP_BLOCKER_MASKS[i]))
+    constexpr size_t addSquares(array<SquareEntry, 64> &squares, const array<Bitboard, 64> &masks,
+                                const array<uint64_t, 64> &magics, const array<uint64_t, 64> &shifts,
+                                std::initializer_list<Direction> directions, size_t offset)
+    {
+        for (Square i = 0; i < 64; i++)
         {
-            const uint32_t index = blockerPositions * BISHOP_MAGICS[i] >> BISHOP_SHIFTS[i];
-            attackingSquares[i][index] = rayAttackingSquares(blockerPositions, i, {Direction::NORTHWEST, Direction::NORTHEAST, Direction::SOUTHWEST, Direction::SOUTHEAST});
+            SquareEntry &entry = squares[i];
+            entry = {masks[i], magics[i], static_cast<uint32_t>(offset), static_cast<uint8_t>(shifts[i])};
+
+            // Go through every subset of the mask, including the empty set
+            uint64_t tableLength = 0;
+            Bitboard blockers = 0;
+            do
+            {
+                const uint64_t blockerIndex = index(entry, blockers);
+                attacks[offset + blockerIndex] = rayAttackingSquares(blockers, i, directions);
+                // Add 1 because the length will be one more than the maximum index
+                tableLength = std::max(tableLength, blockerIndex + 1);
+                blockers = (blockers - masks[i]) & masks[i];
+            } while (blockers != 0);
+            offset += tableLength;
         }
+        return offset;
     }
 
-    return attackingSquares;
-}
-
-// TODO: Use array instead of vector (array of pointers to arrays of different lengths)
-const array<vector<Bitboard>, 64> ROOK_ATTACKING_SQUARES = computeRookAttackingSquares();
-const array<vector<Bitboard>, 64> BISHOP_ATTACKING_SQUARES = computeBishopAttackingSquares();
+    array<SquareEntry, 64> rookSquares{};
+    array<SquareEntry, 64> bishopSquares{};
+    alignas(64) array<Bitboard, maxSliderTableSize(ROOK_SHIFTS) + maxSliderTableSize(BISHOP_SHIFTS)> attacks{};
+};
 
-Bitboard slidingCheckers = 0;
+constexpr SliderAttackTable<SliderIndexing::MAGIC> MAGIC_SLIDER_ATTACKS{};
+#ifdef __BMI2__
+// Both tables are included when PEXT is available, so that the two backends can be compared in the same build
+constexpr SliderAttackTable<SliderIndexing::PEXT> PEXT_SLIDER_ATTACKS{};
+#endif
 
-Bitboard checkResolutionSquares(const Board &board)
+template <SliderIndexing Indexing>
+constexpr const SliderAttackTable<Indexing> &sliderAttackTable()
 {
-    using enum Direction;
-    using pieceIndexes::WHITE_PAWN, pieceIndexes::BLACK_PAWN;
-
-    Bitboard slidingCheckEvasions = 0;
-    const Bitboard king = board.bitboards[Piece{PieceKind::KING, board.sideToMove}.index()];
-    const Square kingPos = bitboards::getMSB(king);
-    // Sliding pieces
-    if (std::popcount(slidingCheckers) > 1)
-    {
-        // Double check, king must move
-        return 0;
-    }
-    if (slidingCheckers != 0)
-    {
-        slidingCheckEvasions = squaresBetweenSquares[kingPos][bitboards::getMSB(slidingCheckers)] |
-                               bitboards::withSquare(
-                                   bitboards::getMSB(slidingCheckers));
-    }
-
-    Bitboard nonSlidingCheckers = 0;
-    // Pawns
-    if (board.sideToMove == WHITE)
+#ifdef __BMI2__
+    if constexpr (Indexing == SliderIndexing::PEXT)
     {
-        nonSlidingCheckers |= ((king & ~bitboards::FILE_A) << 9) & board.bitboards[BLACK_PAWN];
-        nonSlidingCheckers |= ((king & ~bitboards::FILE_H) << 7) & board.bitboards[BLACK_PAWN];
+        return PEXT_SLIDER_ATTACKS;
     }
     else
+#endif
     {
-        nonSlidingCheckers |= ((king & ~bitboards::FILE_H) >> 9) & board.bitboards[WHITE_PAWN];
-        nonSlidingCheckers |= ((king & ~bitboards::FILE_A) >> 7) & board.bitboards[WHITE_PAWN];
+        return MAGIC_SLIDER_ATTACKS;
     }
+}
 
-    // Knights
-    const Bitboard attackingKnights = knightAttackingSquares[kingPos] & board.bitboards[Piece{
-                                                                            PieceKind::KNIGHT, oppositeColor(board.sideToMove)}
-                                                                                            .index()];
-    nonSlidingCheckers |= attackingKnights;
+// The table used by move generation
+constexpr const SliderAttackTable<SLIDER_INDEXING> &SLIDER_ATTACKS = sliderAttackTable<SLIDER_INDEXING>();
 
-    if (slidingCheckers != 0 && nonSlidingCheckers != 0)
-    {
-        // Discovered double check, there are no resolution squares because it cannot be blocked and both pieces
-        // cannot be captured in one move.
-        return 0;
-    }
-    return slidingCheckEvasions | nonSlidingCheckers;
+template <SliderIndexing Indexing>
+Bitboard rookAttacks(Square square, Bitboard occupancy)
+{
+    return sliderAttackTable<Indexing>().rookAttacks(square, occupancy);
 }
 
-array<Bitboard, 64> pinLines{};
-// This should be called before checkResolutionSquares()
-void computePinLinesAndSlidingCheckers(const Board &board, PieceColor side)
+template <SliderIndexing Indexing>
+Bitboard bishopAttacks(Square square, Bitboard occupancy)
 {
-    using enum Direction;
+    return sliderAttackTable<Indexing>().bishopAttacks(square, occupancy);
+}
 
-    pinLines.fill(bitboards::ALL_SQUARES);
-    slidingCheckers = 0;
+template <PieceColor Side>
+CheckInfo computeCheckInfo(const Position &board)
+{
+    using enum Direction;
+    using enum PieceKind;
 
-    const Bitboard king = board.bitboards[Piece{PieceKind::KING, side}.index()];
-    const Bitboard enemyRooks = board.bitboards[Piece{PieceKind::ROOK, oppositeColor(side)}.index()];
-    const Bitboard enemyBishops = board.bitboards[Piece{PieceKind::BISHOP, oppositeColor(side)}.index()];
-    const Bitboard enemyQueens = board.bitboards[Piece{PieceKind::QUEEN, oppositeColor(side)}.index()];
-    const Square kingPos = bitboards::getMSB(king);
+    CheckInfo checkInfo;
+    constexpr PieceColor side = Side;
+    constexpr PieceColor opponent = oppositeColor(side);
+    const Square kingPos = board.getKingSquare(side);
+    const Bitboard king = bitboards::withSquare(kingPos);
+    const Bitboard enemyRooks = board.bitboards[Piece{ROOK, opponent}.index()];
+    const Bitboard enemyBishops = board.bitboards[Piece{BISHOP, opponent}.index()];
+    const Bitboard enemyQueens = board.bitboards[Piece{QUEEN, opponent}.index()];
 
+    // Sliding checkers and pins
     for (const auto [rayBitboard, direction] : SQUARE_RAYS[kingPos])
     {
         const Bitboard orthogonalSliders = rayBitboard & (enemyRooks | enemyQueens);
@@ -476,32 +553,236 @@ void computePinLinesAndSlidingCheckers(const Board &board, PieceColor side)
         if (std::popcount(piecesBetweenKingAndAttacker) == 0)
         {
             // In check from this direction
-            slidingCheckers |= bitboards::withSquare(attackerPos);
+            checkInfo.checkers |= bitboards::withSquare(attackerPos);
             continue;
         }
         if (std::popcount(piecesBetweenKingAndAttacker) == 1)
         {
-            Bitboard friendlyIntersectingPiece = piecesBetweenKingAndAttacker & board.getPieces(side);
-            if (friendlyIntersectingPiece != 0)
-            {
-                // Piece is pinned
-                pinLines[bitboards::getMSB(friendlyIntersectingPiece)] = squaresBetweenSquares[kingPos][attackerPos] | bitboards::withSquare(attackerPos);
-            }
+            // Piece is pinned if it is a friendly piece
+            checkInfo.pinned |= piecesBetweenKingAndAttacker & board.getPieces(side);
         }
         // More than 2 pieces between attacker and king, no pinned pieces on this ray
     }
+
+    // Pawns and knights
+    checkInfo.checkers |= getPawnAttackingSquares<side>(king) & board.bitboards[Piece{PAWN, opponent}.index()];
+    checkInfo.checkers |= knightAttackingSquares[kingPos] & board.bitboards[Piece{KNIGHT, opponent}.index()];
+
+    if (std::popcount(checkInfo.checkers) > 1)
+    {
+        // Double check, king must move because both pieces cannot be captured or blocked in one move
+        checkInfo.checkResolutions = 0;
+    }
+    else if (checkInfo.checkers != 0)
+    {
+        // This is empty for pawns and knights, which can only be captured
+        const Square checkerPos = bitboards::getMSB(checkInfo.checkers);
+        checkInfo.checkResolutions = squaresBetweenSquares[kingPos][checkerPos] | checkInfo.checkers;
+    }
+
+    // Squares from which each piece would attack the enemy king are the squares that piece attacks from the king
+    const Square enemyKingPos = board.getKingSquare(opponent);
+    const Bitboard enemyKing = bitboards::withSquare(enemyKingPos);
+    const Bitboard diagonalCheckSquares = getPieceAttackingSquares<BISHOP>(board.getPieces(), enemyKing);
+    const Bitboard orthogonalCheckSquares = getPieceAttackingSquares<ROOK>(board.getPieces(), enemyKing);
+    checkInfo.checkSquares[static_cast<uint8_t>(PAWN)] = getPawnAttackingSquares<opponent>(enemyKing);
+    checkInfo.checkSquares[static_cast<uint8_t>(KNIGHT)] = knightAttackingSquares[enemyKingPos];
+    checkInfo.checkSquares[static_cast<uint8_t>(BISHOP)] = diagonalCheckSquares;
+    checkInfo.checkSquares[static_cast<uint8_t>(ROOK)] = orthogonalCheckSquares;
+    checkInfo.checkSquares[static_cast<uint8_t>(QUEEN)] = diagonalCheckSquares | orthogonalCheckSquares;
+
+    // Discovered check candidates are found in the same way as pins, but from the enemy king and with friendly sliders
+    const Bitboard friendlyQueens = board.bitboards[Piece{QUEEN, side}.index()];
+    const Bitboard friendlyOrthogonalSliders = board.bitboards[Piece{ROOK, side}.index()] | friendlyQueens;
+    const Bitboard friendlyDiagonalSliders = board.bitboards[Piece{BISHOP, side}.index()] | friendlyQueens;
+    for (const auto [rayBitboard, direction] : SQUARE_RAYS[enemyKingPos])
+    {
+        const Bitboard possibleAttackers =
+            rayBitboard & (direction == NORTH || direction == SOUTH || direction == WEST || direction == EAST
+                               ? friendlyOrthogonalSliders
+                               : friendlyDiagonalSliders);
+        if (possibleAttackers == 0)
+        {
+            continue;
+        }
+        const Square attackerPos = (direction == NORTH || direction == WEST || direction == NORTHWEST || direction == NORTHEAST)
+                                       ? bitboards::getLSB(possibleAttackers)
+                                       : bitboards::getMSB(possibleAttackers);
+        const Bitboard piecesBetween = squaresBetweenSquares[enemyKingPos][attackerPos] & board.getPieces();
+        if (std::popcount(piecesBetween) == 1)
+        {
+            checkInfo.discoveredCheckCandidates |= piecesBetween & board.getPieces(side);
+        }
+    }
+
+    return checkInfo;
+}
+
+CheckInfo computeCheckInfo(const Position &board)
+{
+    return board.sideToMove == WHITE ? computeCheckInfo<WHITE>(board) : computeCheckInfo<BLACK>(board);
+}
+
+/**
+ * Checks whether any of the given sliding pieces attack a square with the given occupancy
+ */
+bool slidersAttackSquare(Square square, Bitboard occupancy, Bitboard diagonalSliders, Bitboard orthogonalSliders)
+{
+    const Bitboard squareBitboard = bitboards::withSquare(square);
+    return (getPieceAttackingSquares<PieceKind::BISHOP>(occupancy, squareBitboard) & diagonalSliders) != 0 ||
+           (getPieceAttackingSquares<PieceKind::ROOK>(occupancy, squareBitboard) & orthogonalSliders) != 0;
 }
 
-void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
+bool givesCheck(const Position &board, Move move)
 {
+    using enum PieceKind;
+
+    const CheckInfo &checkInfo = board.getCheckInfo();
     const PieceColor side = board.sideToMove;
+    const Square start = move.start();
+    const Square end = move.end();
+    const Bitboard startBitboard = bitboards::withSquare(start);
+    const Bitboard endBitboard = bitboards::withSquare(end);
+    const Square enemyKingPos = board.getKingSquare(oppositeColor(side));
+    const Bitboard queens = board.bitboards[Piece{QUEEN, side}.index()];
+    const Bitboard diagonalSliders = board.bitboards[Piece{BISHOP, side}.index()] | queens;
+    const Bitboard orthogonalSliders = board.bitboards[Piece{ROOK, side}.index()] | queens;
+
+    switch (move.moveFlag())
+    {
+    case MoveFlag::ShortCastling:
+    case MoveFlag::LongCastling:
+    {
+        // Only the rook can give check, but it may be on a line that was blocked by the king
+        const bool isShortCastling = move.moveFlag() == MoveFlag::ShortCastling;
+        const Bitboard rookStart = bitboards::withSquare(isShortCastling ? start + 3 : start - 4);
+        const Bitboard rookEnd = bitboards::withSquare(isShortCastling ? end - 1 : end + 1);
+        const Bitboard occupancy = board.getPieces() ^ startBitboard ^ endBitboard ^ rookStart ^ rookEnd;
+        return slidersAttackSquare(enemyKingPos, occupancy, diagonalSliders,
+                                   (orthogonalSliders & ~rookStart) | rookEnd);
+    }
+    case MoveFlag::EnPassant:
+    {
+        // Removing the captured pawn can discover a check, so check the sliding pieces with the occupancy after the move
+        const Bitboard capturedPawn = bitboards::withSquare(side == WHITE ? end + 8 : end - 8);
+        if ((checkInfo.checkSquares[static_cast<uint8_t>(PAWN)] & endBitboard) != 0)
+        {
+            return true;
+        }
+        const Bitboard occupancy = board.getPieces() ^ startBitboard ^ endBitboard ^ capturedPawn;
+        return slidersAttackSquare(enemyKingPos, occupancy, diagonalSliders, orthogonalSliders);
+    }
+    default:
+        break;
+    }
+
+    // Discovered check
+    if ((checkInfo.discoveredCheckCandidates & startBitboard) != 0 &&
+        (lineThroughSquares[enemyKingPos][start] & endBitboard) == 0)
+    {
+        return true;
+    }
+
+    if (move.isPromotion())
+    {
+        // The check squares for the promoted piece are blocked by the pawn if it is on the line to the king
+        const Bitboard occupancy = board.getPieces() & ~startBitboard;
+        const Bitboard enemyKing = bitboards::withSquare(enemyKingPos);
+        switch (move.moveFlag())
+        {
+        case MoveFlag::PromotionKnight:
+            return (knightAttackingSquares[end] & enemyKing) != 0;
+        case MoveFlag::PromotionBishop:
+            return (getPieceAttackingSquares<BISHOP>(occupancy, endBitboard) & enemyKing) != 0;
+        case MoveFlag::PromotionRook:
+            return (getPieceAttackingSquares<ROOK>(occupancy, endBitboard) & enemyKing) != 0;
+        default:
+            return (getPieceAttackingSquares<QUEEN>(occupancy, endBitboard) & enemyKing) != 0;
+        }
+    }
+
+    // Direct check (the king has no check squares)
+    const Piece piece = board.pieceAt(start);
+    return (checkInfo.checkSquares[static_cast<uint8_t>(piece.kind())] & endBitboard) != 0;
+}
+
+/**
+ * Returns the squares that a piece can move to without exposing its king, which is the line through the king and the
+ * piece if it is pinned. Pins are ignored when generating pseudo-legal moves, and are checked by Position::isLegal()
+ * instead.
+ */
+template <MoveLegality Legality = MoveLegality::LEGAL>
+inline Bitboard pinLine(const CheckInfo &checkInfo, Square kingPos, Square piecePos)
+{
+    if constexpr (Legality == MoveLegality::PSEUDO_LEGAL)
+    {
+        return bitboards::ALL_SQUARES;
+    }
+    return (checkInfo.pinned & bitboards::withSquare(piecePos)) != 0
+               ? lineThroughSquares[kingPos][piecePos]
+               : bitboards::ALL_SQUARES;
+}
+
+/**
+ * Returns the pawns of the side to move that can legally capture en passant, which must only be called when there is an
+ * en passant target square
+ */
+template <PieceColor Side>
+Bitboard legalEnPassantPawns(const Position &board)
+{
+    constexpr int direction = Side == WHITE ? 1 : -1;
+    const int8_t ep = board.getEnPassantTargetSquare();
+    const Bitboard pawns = board.bitboards[Piece{PieceKind::PAWN, Side}.index()];
+    Bitboard enPassantPawns = pawns & (bitboards::withSquare(ep + 9 * direction) | bitboards::withSquare(
+                                                                                       ep + 7 * direction));
+    Bitboard legalPawns = 0;
+    while (enPassantPawns != 0)
+    {
+        const Square i = bitboards::popMSB(enPassantPawns);
+        if ((bitboards::withSquare(i) & bitboards::FILE_A) != 0 && (bitboards::withSquare(ep) & bitboards::FILE_H) != 0)
+        {
+            continue;
+        }
+        if ((bitboards::withSquare(i) & bitboards::FILE_H) != 0 &&
+            (bitboards::withSquare(ep) & bitboards::FILE_A) != 0)
+        {
+            continue;
+        }
+        /*
+        First, check whether we are in check after en passant because there are edge cases with the pin
+        detection. This is done by making the move on a copy of the position, which is cheap, and en passant is
+        rare so there shouldn't be a significant performance impact.
+        */
+        Position positionAfterMove = board;
+        positionAfterMove.makeMove(Move{i, static_cast<Square>(ep), MoveFlag::EnPassant});
+        if (positionAfterMove.isSideInCheck(Side))
+        {
+            continue;
+        }
+
+        legalPawns |= bitboards::withSquare(i);
+    }
+    return legalPawns;
+}
+
+/**
+ * Generates pawn moves, where quiet promotions are generated with the captures because they change the material
+ */
+template <PieceColor Side, GenerationMode Mode, MoveLegality Legality, size_t Capacity>
+void generatePawnMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard checkResolutions)
+{
+    constexpr bool generateQuiets = Mode != GenerationMode::CAPTURES;
+    constexpr bool generateCaptures = Mode != GenerationMode::QUIETS;
+    constexpr PieceColor side = Side;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(side);
     const Bitboard pawns = board.bitboards[Piece{PieceKind::PAWN, side}.index()];
     const Bitboard emptySquares = ~board.getPieces();
     const Bitboard enemyPieces = board.getPieces(oppositeColor(side));
-    const int direction = side == WHITE ? 1 : -1;
+    constexpr int direction = side == WHITE ? 1 : -1;
 
-    const Bitboard doublePushTarget = side == WHITE ? bitboards::RANK_4 : bitboards::RANK_5;
-    const Bitboard promotionRank = side == WHITE ? bitboards::RANK_8 : bitboards::RANK_1;
+    constexpr Bitboard doublePushTarget = side == WHITE ? bitboards::RANK_4 : bitboards::RANK_5;
+    constexpr Bitboard promotionRank = side == WHITE ? bitboards::RANK_8 : bitboards::RANK_1;
     Bitboard singlePushes = (side == WHITE ? pawns << 8 : pawns >> 8) & emptySquares;
     Bitboard doublePushes = (side == WHITE ? singlePushes << 8 : singlePushes >> 8) & emptySquares &
                             doublePushTarget;
@@ -522,13 +803,27 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
     leftCaptures &= ~promotionRank;
     rightCaptures &= ~promotionRank;
 
+    if constexpr (!generateQuiets)
+    {
+        singlePushes = 0;
+        doublePushes = 0;
+    }
+    if constexpr (!generateCaptures)
+    {
+        leftCaptures = 0;
+        rightCaptures = 0;
+        singlePushesWithPromotion = 0;
+        leftCapturesWithPromotion = 0;
+        rightCapturesWithPromotion = 0;
+    }
+
     // Pawn pushes
     while (singlePushes != 0)
     {
         const Square i = bitboards::popMSB(singlePushes);
         const Square start = i + 8 * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::None);
         }
@@ -538,7 +833,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         const Square i = bitboards::popMSB(doublePushes);
         const Square start = i + 16 * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::None);
         }
@@ -550,7 +845,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         Square i = bitboards::popMSB(leftCaptures);
         const Square start = i + (side == WHITE ? 9 : 7) * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::None);
         }
@@ -560,7 +855,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         Square i = bitboards::popMSB(rightCaptures);
         const Square start = i + (side == WHITE ? 7 : 9) * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::None);
         }
@@ -572,7 +867,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         const Square i = bitboards::popMSB(singlePushesWithPromotion);
         const Square start = i + 8 * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::PromotionQueen);
             moves.emplace_back(start, i, MoveFlag::PromotionRook);
@@ -585,7 +880,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         Square i = bitboards::popMSB(leftCapturesWithPromotion);
         const Square start = i + (side == WHITE ? 9 : 7) * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::PromotionQueen);
             moves.emplace_back(start, i, MoveFlag::PromotionRook);
@@ -598,7 +893,7 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
         const Square i = bitboards::popMSB(rightCapturesWithPromotion);
         const Square start = i + (side == WHITE ? 7 : 9) * direction;
         const Bitboard targetBitboard = bitboards::withSquare(i);
-        if ((checkResolutions & targetBitboard) != 0 && (pinLines[start] & targetBitboard) != 0)
+        if ((checkResolutions & targetBitboard) != 0 && (pinLine<Legality>(checkInfo, kingPos, start) & targetBitboard) != 0)
         {
             moves.emplace_back(start, i, MoveFlag::PromotionQueen);
             moves.emplace_back(start, i, MoveFlag::PromotionRook);
@@ -609,44 +904,27 @@ void generatePawnMoves(MoveList &moves, Board &board, Bitboard checkResolutions)
 
     // En Passant
     const int8_t ep = board.getEnPassantTargetSquare();
-    if (ep != -1)
+    if (generateCaptures && ep != -1)
         [[unlikely]]
     {
-        Bitboard enPassantPawns = pawns & (bitboards::withSquare(ep + 9 * direction) | bitboards::withSquare(
-                                                                                           ep + 7 * direction));
+        // The pawns that could capture en passant are the squares an enemy pawn on the target square would attack
+        Bitboard enPassantPawns = Legality == MoveLegality::LEGAL
+                                      ? legalEnPassantPawns<Side>(board)
+                                      : getPawnAttackingSquares<oppositeColor(Side)>(bitboards::withSquare(ep)) & pawns;
         while (enPassantPawns != 0)
         {
             const Square i = bitboards::popMSB(enPassantPawns);
-            if ((bitboards::withSquare(i) & bitboards::FILE_A) != 0 && (bitboards::withSquare(ep) & bitboards::FILE_H) != 0)
-            {
-                continue;
-            }
-            if ((bitboards::withSquare(i) & bitboards::FILE_H) != 0 &&
-                (bitboards::withSquare(ep) & bitboards::FILE_A) != 0)
-            {
-                continue;
-            }
-            /*
-            First, check whether we are in check after en passant because there are edge cases with the pin
-            detection. This is not particularly efficient and there are better ways of doing this, but en passant
-            is rare so there shouldn't be a significant performance impact. (TODO: Improve)
-            */
-            board.makeMove(Move{i, static_cast<Square>(ep), MoveFlag::EnPassant});
-            const bool enPassantPossible = !board.isSideInCheck(side);
-            board.unmakeMove();
-            if (!enPassantPossible)
-            {
-                continue;
-            }
-
             moves.emplace_back(i, ep, MoveFlag::EnPassant);
         }
     }
 }
 
-void generateKnightMoves(MoveList &moves, const Board &board, Bitboard checkResolutions)
+template <PieceColor Side, MoveLegality Legality, size_t Capacity>
+void generateKnightMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard targets)
 {
-    const PieceColor side = board.sideToMove;
+    constexpr PieceColor side = Side;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(side);
     Bitboard knights = board.bitboards[Piece{PieceKind::KNIGHT, side}.index()];
 
     while (knights != 0)
@@ -654,9 +932,7 @@ void generateKnightMoves(MoveList &moves, const Board &board, Bitboard checkReso
         const Square i = bitboards::popMSB(knights);
         Bitboard attackingSquares = knightAttackingSquares[i];
 
-        // Ignore squares that are occupied by friendly pieces
-        attackingSquares &= ~board.getPieces(side);
-        attackingSquares &= pinLines[i] & checkResolutions;
+        attackingSquares &= pinLine<Legality>(checkInfo, kingPos, i) & targets;
         while (attackingSquares != 0)
         {
             const Square end = bitboards::popMSB(attackingSquares);
@@ -665,21 +941,21 @@ void generateKnightMoves(MoveList &moves, const Board &board, Bitboard checkReso
     }
 }
 
-void generateBishopMoves(MoveList &moves, const Board &board, Bitboard checkResolutions)
+template <PieceColor Side, MoveLegality Legality, size_t Capacity>
+void generateBishopMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard targets)
 {
-    const PieceColor side = board.sideToMove;
+    constexpr PieceColor side = Side;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(side);
     Bitboard bishops = board.bitboards[Piece{PieceKind::BISHOP, side}.index()];
 
     while (bishops != 0)
     {
         const Square i = bitboards::popMSB(bishops);
 
-        const Bitboard blockers = board.getPieces() & BISHOP_BLOCKER_MASKS[i];
-        Bitboard attackingSquares = BISHOP_ATTACKING_SQUARES[i][blockers * BISHOP_MAGICS[i] >> BISHOP_SHIFTS[i]];
+        Bitboard attackingSquares = SLIDER_ATTACKS.bishopAttacks(i, board.getPieces());
 
-        // Ignore squares that are occupied by friendly pieces
-        attackingSquares &= ~board.getPieces(side);
-        attackingSquares &= pinLines[i] & checkResolutions;
+        attackingSquares &= pinLine<Legality>(checkInfo, kingPos, i) & targets;
         while (attackingSquares != 0)
         {
             const Square end = bitboards::popMSB(attackingSquares);
@@ -688,21 +964,21 @@ void generateBishopMoves(MoveList &moves, const Board &board, Bitboard checkReso
     }
 }
 
-void generateRookMoves(MoveList &moves, const Board &board, Bitboard checkResolutions)
+template <PieceColor Side, MoveLegality Legality, size_t Capacity>
+void generateRookMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard targets)
 {
-    const PieceColor side = board.sideToMove;
+    constexpr PieceColor side = Side;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(side);
     Bitboard rooks = board.bitboards[Piece{PieceKind::ROOK, side}.index()];
 
     while (rooks != 0)
     {
         const Square i = bitboards::popMSB(rooks);
 
-        const Bitboard blockers = board.getPieces() & ROOK_BLOCKER_MASKS[i];
-        Bitboard attackingSquares = ROOK_ATTACKING_SQUARES[i][blockers * ROOK_MAGICS[i] >> ROOK_SHIFTS[i]];
+        Bitboard attackingSquares = SLIDER_ATTACKS.rookAttacks(i, board.getPieces());
 
-        // Ignore squares that are occupied by friendly pieces
-        attackingSquares &= ~board.getPieces(side);
-        attackingSquares &= pinLines[i] & checkResolutions;
+        attackingSquares &= pinLine<Legality>(checkInfo, kingPos, i) & targets;
         while (attackingSquares != 0)
         {
             const Square end = bitboards::popMSB(attackingSquares);
@@ -711,24 +987,22 @@ void generateRookMoves(MoveList &moves, const Board &board, Bitboard checkResolu
     }
 }
 
-void generateQueenMoves(MoveList &moves, const Board &board, Bitboard checkResolutions)
+template <PieceColor Side, MoveLegality Legality, size_t Capacity>
+void generateQueenMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard targets)
 {
-    const PieceColor side = board.sideToMove;
+    constexpr PieceColor side = Side;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(side);
     Bitboard queens = board.bitboards[Piece{PieceKind::QUEEN, side}.index()];
 
     while (queens != 0)
     {
         const Square i = bitboards::popMSB(queens);
 
-        const Bitboard horizontalBlockers = board.getPieces() & ROOK_BLOCKER_MASKS[i];
-        const Bitboard diagonalBlockers = board.getPieces() & BISHOP_BLOCKER_MASKS[i];
-        const Bitboard horizontalSquares = ROOK_ATTACKING_SQUARES[i][(horizontalBlockers * ROOK_MAGICS[i]) >> ROOK_SHIFTS[i]];
-        const Bitboard diagonalSquares = BISHOP_ATTACKING_SQUARES[i][(diagonalBlockers * BISHOP_MAGICS[i]) >> BISHOP_SHIFTS[i]];
-        Bitboard attackingSquares = horizontalSquares | diagonalSquares;
+        Bitboard attackingSquares = SLIDER_ATTACKS.rookAttacks(i, board.getPieces()) |
+                                    SLIDER_ATTACKS.bishopAttacks(i, board.getPieces());
 
-        // Ignore squares that are occupied by friendly pieces
-        attackingSquares &= ~board.getPieces(side);
-        attackingSquares &= pinLines[i] & checkResolutions;
+        attackingSquares &= pinLine<Legality>(checkInfo, kingPos, i) & targets;
         while (attackingSquares != 0)
         {
             const Square end = bitboards::popMSB(attackingSquares);
@@ -737,25 +1011,86 @@ void generateQueenMoves(MoveList &moves, const Board &board, Bitboard checkResol
     }
 }
 
-void generateKingMoves(MoveList &moves, const Board &board)
+/**
+ * Squares attacked by Attacker with the given occupancy, using ATTACK_KERNEL. The Kogge-Stone kernel fills the sliders
+ * of both sides at once, so this takes the attacker's half of its attack maps.
+ */
+template <PieceColor Attacker>
+Bitboard attackedSquares(const Position &board, Bitboard occupancy)
+{
+    if constexpr (ATTACK_KERNEL == AttackKernel::KOGGE_STONE)
+    {
+        const AttackMaps attackMaps = computeAttackMaps<AttackKernel::KOGGE_STONE>(board, occupancy);
+        return Attacker == WHITE ? attackMaps.white : attackMaps.black;
+    }
+    else
+    {
+        return board.getAttackingSquares<Attacker>(occupancy);
+    }
+}
+
+/**
+ * Whether the king can castle on the king side, given the squares attacked by the opponent. The king must not be in
+ * check.
+ */
+template <PieceColor Side>
+bool canShortCastle(const Position &board, Square kingPos, Bitboard opponentAttackingSquares)
+{
+    const bool hasRight = Side == WHITE ? board.canWhiteShortCastle() : board.canBlackShortCastle();
+    return hasRight && (opponentAttackingSquares & bitboards::withSquare(kingPos + 1)) == 0 &&
+           (opponentAttackingSquares & bitboards::withSquare(kingPos + 2)) == 0 && board.isSquareEmpty(kingPos + 1) &&
+           board.isSquareEmpty(kingPos + 2);
+}
+
+/**
+ * Whether the king can castle on the queen side, given the squares attacked by the opponent. The king must not be in
+ * check.
+ */
+template <PieceColor Side>
+bool canLongCastle(const Position &board, Square kingPos, Bitboard opponentAttackingSquares)
+{
+    const bool hasRight = Side == WHITE ? board.canWhiteLongCastle() : board.canBlackLongCastle();
+    return hasRight && (opponentAttackingSquares & bitboards::withSquare(kingPos - 1)) == 0 &&
+           (opponentAttackingSquares & bitboards::withSquare(kingPos - 2)) == 0 && board.isSquareEmpty(kingPos - 1) &&
+           board.isSquareEmpty(kingPos - 2) && board.isSquareEmpty(kingPos - 3);
+}
+
+template <PieceColor Side, GenerationMode Mode, MoveLegality Legality, size_t Capacity>
+void generateKingMoves(BasicMoveList<Capacity> &moves, const Position &board, Bitboard targets)
 {
     using enum PieceKind;
-    const PieceColor side = board.sideToMove;
-    const Bitboard king = board.bitboards[Piece{KING, side}.index()];
-    const Square i = bitboards::getMSB(king);
-    Bitboard attackingSquares = kingAttackingSquares[i];
-    attackingSquares &= ~board.getPieces(side);
+    constexpr PieceColor side = Side;
+    const Square i = board.getKingSquare(side);
+    const Bitboard king = bitboards::withSquare(i);
+    Bitboard attackingSquares = kingAttackingSquares[i] & targets;
+    constexpr bool generateCastling = Mode == GenerationMode::ALL || Mode == GenerationMode::QUIETS;
+
+    if constexpr (Legality == MoveLegality::PSEUDO_LEGAL)
+    {
+        // The opponent's attacks are the most expensive part of generating legal moves, so the king's moves, including
+        // castling through an attacked square, are left for Position::isLegal() to check
+        while (attackingSquares != 0)
+        {
+            moves.emplace_back(i, bitboards::popMSB(attackingSquares), MoveFlag::None);
+        }
+        if (generateCastling && board.getCheckInfo().checkers == 0)
+        {
+            if (canShortCastle<Side>(board, i, 0))
+            {
+                moves.emplace_back(i, i + 2, MoveFlag::ShortCastling);
+            }
+            if (canLongCastle<Side>(board, i, 0))
+            {
+                moves.emplace_back(i, i - 2, MoveFlag::LongCastling);
+            }
+        }
+        return;
+    }
 
-    Bitboard opponentAttackingSquares = board.getAttackingSquares(oppositeColor(side));
     // Generate check evasions when the king moves away from a sliding piece along its attacking diagonal
     // This is done by generating the attacking squares for sliding pieces as if the king wasn't there
     const Bitboard allPiecesWithoutKing = board.getPieces() & ~king;
-    const Bitboard enemyBishops = board.bitboards[Piece{BISHOP, oppositeColor(side)}.index()];
-    const Bitboard enemyRooks = board.bitboards[Piece{ROOK, oppositeColor(side)}.index()];
-    const Bitboard enemyQueens = board.bitboards[Piece{QUEEN, oppositeColor(side)}.index()];
-    opponentAttackingSquares |= getPieceAttackingSquares<BISHOP>(allPiecesWithoutKing, enemyBishops);
-    opponentAttackingSquares |= getPieceAttackingSquares<ROOK>(allPiecesWithoutKing, enemyRooks);
-    opponentAttackingSquares |= getPieceAttackingSquares<QUEEN>(allPiecesWithoutKing, enemyQueens);
+    const Bitboard opponentAttackingSquares = attackedSquares<oppositeColor(side)>(board, allPiecesWithoutKing);
 
     // Prevent the king from moving into check
     attackingSquares &= ~opponentAttackingSquares;
@@ -767,63 +1102,242 @@ void generateKingMoves(MoveList &moves, const Board &board)
     }
 
     // Castling
-    if (!board.isSideInCheck(side))
+    if (generateCastling && (opponentAttackingSquares & king) == 0)
     {
-        if (side == WHITE)
+        if (canShortCastle<Side>(board, i, opponentAttackingSquares))
         {
-            if (board.canWhiteShortCastle() && (opponentAttackingSquares & bitboards::withSquare(i + 1)) == 0 && (opponentAttackingSquares & bitboards::withSquare(i + 2)) == 0 && board.isSquareEmpty(i + 1) && board.isSquareEmpty(i + 2))
-            {
-                moves.emplace_back(i, i + 2, MoveFlag::ShortCastling);
-            }
-            if (board.canWhiteLongCastle() && (opponentAttackingSquares & bitboards::withSquare(i - 1)) == 0 && (opponentAttackingSquares & bitboards::withSquare(i - 2)) == 0 && board.isSquareEmpty(i - 1) && board.isSquareEmpty(i - 2) && board.isSquareEmpty(i - 3))
-            {
-                moves.emplace_back(i, i - 2, MoveFlag::LongCastling);
-            }
+            moves.emplace_back(i, i + 2, MoveFlag::ShortCastling);
         }
-        else
+        if (canLongCastle<Side>(board, i, opponentAttackingSquares))
         {
-            if (board.canBlackShortCastle() && (opponentAttackingSquares & bitboards::withSquare(i + 1)) == 0 && (opponentAttackingSquares & bitboards::withSquare(i + 2)) == 0 && board.isSquareEmpty(i + 1) && board.isSquareEmpty(i + 2))
-            {
-                moves.emplace_back(i, i + 2, MoveFlag::ShortCastling);
-            }
-            if (board.canBlackLongCastle() && (opponentAttackingSquares & bitboards::withSquare(i - 1)) == 0 && (opponentAttackingSquares & bitboards::withSquare(i - 2)) == 0 && board.isSquareEmpty(i - 1) && board.isSquareEmpty(i - 2) && board.isSquareEmpty(i - 3))
-            {
-                moves.emplace_back(i, i - 2, MoveFlag::LongCastling);
-            }
+            moves.emplace_back(i, i - 2, MoveFlag::LongCastling);
         }
     }
 }
 
-MoveList generateLegalMoves(Board &board)
+template <PieceColor Side, GenerationMode Mode, MoveLegality Legality, size_t Capacity>
+void generateMoves(const Position &board, BasicMoveList<Capacity> &moves)
+{
+    // Squares to which a piece other than the king can move to block a check
+    const Bitboard checkResolutions = board.getCheckInfo().checkResolutions;
+
+    // Squares that the moves of this mode may end on, which excludes squares occupied by friendly pieces
+    Bitboard targets = ~board.getPieces(Side);
+    if constexpr (Mode == GenerationMode::CAPTURES)
+    {
+        targets = board.getPieces(oppositeColor(Side));
+    }
+    else if constexpr (Mode == GenerationMode::QUIETS)
+    {
+        targets = ~board.getPieces();
+    }
+
+    // Only the king can move out of double check, in which case there are no check resolutions
+    if (checkResolutions != 0)
+    {
+        const Bitboard pieceTargets = targets & checkResolutions;
+        generatePawnMoves<Side, Mode, Legality>(moves, board, checkResolutions);
+        generateKnightMoves<Side, Legality>(moves, board, pieceTargets);
+        generateBishopMoves<Side, Legality>(moves, board, pieceTargets);
+        generateRookMoves<Side, Legality>(moves, board, pieceTargets);
+        generateQueenMoves<Side, Legality>(moves, board, pieceTargets);
+    }
+    generateKingMoves<Side, Mode, Legality>(moves, board, targets);
+}
+
+template <PieceColor Side>
+MoveList generateLegalMoves(const Position &board)
 {
     MoveList moves;
+    generateMoves<Side, GenerationMode::ALL, MoveLegality::LEGAL>(board, moves);
+    return moves;
+}
 
-    const PieceColor sideToMove = board.sideToMove;
-    // Squares to which a piece other than the king can move to block a check
-    computePinLinesAndSlidingCheckers(board, sideToMove);
-    const Bitboard checkResolutions = board.isSideInCheck(sideToMove)
-                                          ? checkResolutionSquares(board)
-                                          : bitboards::ALL_SQUARES;
-
-    generatePawnMoves(moves, board, checkResolutions);
-    generateKnightMoves(moves, board, checkResolutions);
-    generateBishopMoves(moves, board, checkResolutions);
-    generateRookMoves(moves, board, checkResolutions);
-    generateQueenMoves(moves, board, checkResolutions);
-    generateKingMoves(moves, board);
+/**
+ * Dispatches to the generator for a mode chosen at runtime
+ */
+template <PieceColor Side, MoveLegality Legality, size_t Capacity>
+void generateMovesOfMode(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode)
+{
+    if constexpr (Capacity < MAX_MOVES)
+    {
+        // Only captures are guaranteed to fit in a smaller list. The bound doesn't depend on legality, so pseudo-legal
+        // captures fit as well.
+        if (mode != GenerationMode::CAPTURES)
+        {
+            throw std::invalid_argument{"Only captures can be generated into a list smaller than MAX_MOVES"};
+        }
+        generateMoves<Side, GenerationMode::CAPTURES, Legality>(board, moves);
+    }
+    else
+    {
+        switch (mode)
+        {
+        case GenerationMode::ALL:
+            generateMoves<Side, GenerationMode::ALL, Legality>(board, moves);
+            break;
+        case GenerationMode::CAPTURES:
+            generateMoves<Side, GenerationMode::CAPTURES, Legality>(board, moves);
+            break;
+        case GenerationMode::QUIETS:
+            generateMoves<Side, GenerationMode::QUIETS, Legality>(board, moves);
+            break;
+        case GenerationMode::EVASIONS:
+            generateMoves<Side, GenerationMode::EVASIONS, Legality>(board, moves);
+            break;
+        }
+    }
+}
+
+template <PieceColor Side, size_t Capacity>
+void generateLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode)
+{
+    generateMovesOfMode<Side, MoveLegality::LEGAL>(board, moves, mode);
+}
+
+template <size_t Capacity>
+void generatePseudoLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode)
+{
+    if (board.sideToMove == WHITE)
+    {
+        generateMovesOfMode<WHITE, MoveLegality::PSEUDO_LEGAL>(board, moves, mode);
+    }
+    else
+    {
+        generateMovesOfMode<BLACK, MoveLegality::PSEUDO_LEGAL>(board, moves, mode);
+    }
+}
+
+template <size_t Capacity>
+void generateLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode)
+{
+    if (board.sideToMove == WHITE)
+    {
+        generateLegalMoves<WHITE>(board, moves, mode);
+    }
+    else
+    {
+        generateLegalMoves<BLACK>(board, moves, mode);
+    }
+}
+
+MoveList generateLegalMoves(const Position &board)
+{
+    return board.sideToMove == WHITE ? generateLegalMoves<WHITE>(board) : generateLegalMoves<BLACK>(board);
+}
 
+MoveList generateLegalMoves(const Position &board, GenerationMode mode)
+{
+    MoveList moves;
+    generateLegalMoves(board, moves, mode);
     return moves;
 }
 
+/**
+ * Counts the moves of the given pawns that end on the allowed squares, counting each promotion four times
+ */
+template <PieceColor Side>
+size_t countPawnMoves(Bitboard pawns, Bitboard emptySquares, Bitboard enemyPieces, Bitboard allowed)
+{
+    constexpr Bitboard doublePushTarget = Side == WHITE ? bitboards::RANK_4 : bitboards::RANK_5;
+    constexpr Bitboard promotionRank = Side == WHITE ? bitboards::RANK_8 : bitboards::RANK_1;
+    const Bitboard singlePushes = (Side == WHITE ? pawns << 8 : pawns >> 8) & emptySquares;
+    const Bitboard doublePushes = (Side == WHITE ? singlePushes << 8 : singlePushes >> 8) & emptySquares &
+                                  doublePushTarget & allowed;
+    // Two pawns can capture on the same square, so the two capture directions are counted separately
+    const Bitboard leftCaptures = (Side == WHITE
+                                       ? (pawns & ~bitboards::FILE_A) << 9
+                                       : (pawns & ~bitboards::FILE_A) >> 7) &
+                                  enemyPieces & allowed;
+    const Bitboard rightCaptures = (Side == WHITE
+                                        ? (pawns & ~bitboards::FILE_H) << 7
+                                        : (pawns & ~bitboards::FILE_H) >> 9) &
+                                   enemyPieces & allowed;
+    const Bitboard allowedPushes = singlePushes & allowed;
+
+    return std::popcount(allowedPushes & ~promotionRank) + std::popcount(doublePushes) +
+           std::popcount(leftCaptures & ~promotionRank) + std::popcount(rightCaptures & ~promotionRank) +
+           4 * (std::popcount(allowedPushes & promotionRank) + std::popcount(leftCaptures & promotionRank) +
+                std::popcount(rightCaptures & promotionRank));
+}
+
+template <PieceColor Side>
+size_t countLegalMoves(const Position &board)
+{
+    using enum PieceKind;
+    const CheckInfo &checkInfo = board.getCheckInfo();
+    const Square kingPos = board.getKingSquare(Side);
+    const Bitboard occupancy = board.getPieces();
+    const Bitboard friendlyPieces = board.getPieces(Side);
+    size_t count = 0;
+
+    // Only the king can move out of double check, in which case there are no check resolutions
+    if (checkInfo.checkResolutions != 0)
+    {
+        const Bitboard targets = ~friendlyPieces & checkInfo.checkResolutions;
+        const Bitboard emptySquares = ~occupancy;
+        const Bitboard enemyPieces = board.getPieces(oppositeColor(Side));
+
+        // Pawns that aren't pinned are counted all at once, and pinned pawns one at a time along their pin line
+        const Bitboard pawns = board.bitboards[Piece{PAWN, Side}.index()];
+        count += countPawnMoves<Side>(pawns & ~checkInfo.pinned, emptySquares, enemyPieces,
+                                      checkInfo.checkResolutions);
+        Bitboard pinnedPawns = pawns & checkInfo.pinned;
+        while (pinnedPawns != 0)
+        {
+            const Square i = bitboards::popMSB(pinnedPawns);
+            count += countPawnMoves<Side>(bitboards::withSquare(i), emptySquares, enemyPieces,
+                                          checkInfo.checkResolutions & lineThroughSquares[kingPos][i]);
+        }
+        if (board.getEnPassantTargetSquare() != -1)
+            [[unlikely]]
+        {
+            count += std::popcount(legalEnPassantPawns<Side>(board));
+        }
+
+        // A pinned knight can never move along the pin line
+        Bitboard knights = board.bitboards[Piece{KNIGHT, Side}.index()] & ~checkInfo.pinned;
+        while (knights != 0)
+        {
+            count += std::popcount(knightAttackingSquares[bitboards::popMSB(knights)] & targets);
+        }
+
+        const Bitboard queens = board.bitboards[Piece{QUEEN, Side}.index()];
+        Bitboard diagonalSliders = board.bitboards[Piece{BISHOP, Side}.index()] | queens;
+        while (diagonalSliders != 0)
+        {
+            const Square i = bitboards::popMSB(diagonalSliders);
+            count += std::popcount(SLIDER_ATTACKS.bishopAttacks(i, occupancy) & pinLine(checkInfo, kingPos, i) &
+                                   targets);
+        }
+        Bitboard orthogonalSliders = board.bitboards[Piece{ROOK, Side}.index()] | queens;
+        while (orthogonalSliders != 0)
+        {
+            const Square i = bitboards::popMSB(orthogonalSliders);
+            count += std::popcount(SLIDER_ATTACKS.rookAttacks(i, occupancy) & pinLine(checkInfo, kingPos, i) &
+                                   targets);
+        }
+    }
+
+    const Bitboard king = bitboards::withSquare(kingPos);
+    const Bitboard opponentAttackingSquares = attackedSquares<oppositeColor(Side)>(board, occupancy & ~king);
+    count += std::popcount(kingAttackingSquares[kingPos] & ~friendlyPieces & ~opponentAttackingSquares);
+    if (checkInfo.checkers == 0)
+    {
+        count += canShortCastle<Side>(board, kingPos, opponentAttackingSquares);
+        count += canLongCastle<Side>(board, kingPos, opponentAttackingSquares);
+    }
+    return count;
+}
+
+size_t countLegalMoves(const Position &board)
+{
+    return board.sideToMove == WHITE ? countLegalMoves<WHITE>(board) : countLegalMoves<BLACK>(board);
+}
+
 Bitboard getPawnAttackingSquares(Bitboard pawns, PieceColor side)
 {
-    const Bitboard leftCaptures = side == WHITE
-                                      ? (pawns & ~bitboards::FILE_A) << 9
-                                      : (pawns & ~bitboards::FILE_A) >> 7;
-    const Bitboard rightCaptures = side == WHITE
-                                       ? (pawns & ~bitboards::FILE_H) << 7
-                                       : (pawns & ~bitboards::FILE_H) >> 9;
-    return leftCaptures | rightCaptures;
+    return side == WHITE ? getPawnAttackingSquares<WHITE>(pawns) : getPawnAttackingSquares<BLACK>(pawns);
 }
 
 std::array<Bitboard, 64> getBishopBlockerMasks()
@@ -836,6 +1350,110 @@ std::array<Bitboard, 64> getRookBlockerMasks()
     return ROOK_BLOCKER_MASKS;
 }
 
+#ifdef __AVX2__
+/**
+ * Kogge-Stone fill of the sliders in each lane through the empty squares, in the direction of that lane. Lanes 0 and 1
+ * shift towards a8 and lanes 2 and 3 towards h1, each by its own amount, and the wrap mask of a lane removes the squares
+ * that its shift would wrap around from one side of the board to the other. Returns the attacked squares in each lane.
+ */
+inline __m256i koggeStoneAttacks(__m256i sliders, __m256i empty, __m256i shifts, __m256i wrapMasks)
+{
+    const auto shift = [](__m256i bitboards, __m256i amounts)
+    {
+        return _mm256_blend_epi32(_mm256_sllv_epi64(bitboards, amounts), _mm256_srlv_epi64(bitboards, amounts), 0xF0);
+    };
+
+    empty = _mm256_and_si256(empty, wrapMasks);
+    // Each step doubles the distance filled, so three steps cover the seven squares a slider can move
+    __m256i step = shifts;
+    for (int i = 0; i < 3; i++)
+    {
+        sliders = _mm256_or_si256(sliders, _mm256_and_si256(empty, shift(sliders, step)));
+        empty = _mm256_and_si256(empty, shift(empty, step));
+        step = _mm256_add_epi64(step, step);
+    }
+    return _mm256_and_si256(shift(sliders, shifts), wrapMasks);
+}
+
+inline Bitboard orLanes(__m256i bitboards)
+{
+    const __m128i halves = _mm_or_si128(_mm256_castsi256_si128(bitboards), _mm256_extracti128_si256(bitboards, 1));
+    return static_cast<Bitboard>(_mm_cvtsi128_si64(halves)) | static_cast<Bitboard>(_mm_extract_epi64(halves, 1));
+}
+
+/**
+ * Knight and king attacks computed set-wise from all knights or kings of a side at once. A shift towards a8 by one is
+ * one file to the west.
+ */
+constexpr Bitboard knightAttacksSetwise(Bitboard knights)
+{
+    constexpr Bitboard notFileA = ~bitboards::FILE_A;
+    constexpr Bitboard notFileH = ~bitboards::FILE_H;
+    constexpr Bitboard notFilesAB = ~(bitboards::FILE_A | bitboards::FILE_A >> 1);
+    constexpr Bitboard notFilesGH = ~(bitboards::FILE_H | bitboards::FILE_H << 1);
+    return ((knights << 17 | knights >> 15) & notFileH) | ((knights << 15 | knights >> 17) & notFileA) |
+           ((knights << 10 | knights >> 6) & notFilesGH) | ((knights << 6 | knights >> 10) & notFilesAB);
+}
+
+constexpr Bitboard kingAttacksSetwise(Bitboard kings)
+{
+    const Bitboard row = kings | ((kings << 1) & ~bitboards::FILE_H) | ((kings >> 1) & ~bitboards::FILE_A);
+    return (row | row << 8 | row >> 8) & ~kings;
+}
+
+AttackMaps koggeStoneAttackMaps(const Position &board, Bitboard occupancy)
+{
+    using enum PieceKind;
+    const auto pieces = [&](PieceKind kind, PieceColor side)
+    {
+        return board.bitboards[Piece{kind, side}.index()];
+    };
+    const auto broadcast = [](Bitboard bitboard)
+    {
+        return _mm256_set1_epi64x(static_cast<int64_t>(bitboard));
+    };
+
+    // The lanes are north, west, south, east for orthogonal sliders and northwest, northeast, southwest, southeast for
+    // diagonal sliders, but _mm256_set_epi64x takes them from lane 3 down to lane 0
+    const __m256i orthogonalShifts = _mm256_set_epi64x(1, 8, 1, 8);
+    const __m256i orthogonalMasks = _mm256_set_epi64x(static_cast<int64_t>(~bitboards::FILE_A), -1,
+                                                      static_cast<int64_t>(~bitboards::FILE_H), -1);
+    const __m256i diagonalShifts = _mm256_set_epi64x(9, 7, 7, 9);
+    const __m256i diagonalMasks = _mm256_set_epi64x(
+        static_cast<int64_t>(~bitboards::FILE_A), static_cast<int64_t>(~bitboards::FILE_H),
+        static_cast<int64_t>(~bitboards::FILE_A), static_cast<int64_t>(~bitboards::FILE_H));
+    const __m256i empty = broadcast(~occupancy);
+
+    const __m256i whiteSliders = _mm256_or_si256(
+        koggeStoneAttacks(broadcast(pieces(ROOK, WHITE) | pieces(QUEEN, WHITE)), empty, orthogonalShifts,
+                          orthogonalMasks),
+        koggeStoneAttacks(broadcast(pieces(BISHOP, WHITE) | pieces(QUEEN, WHITE)), empty, diagonalShifts,
+                          diagonalMasks));
+    const __m256i blackSliders = _mm256_or_si256(
+        koggeStoneAttacks(broadcast(pieces(ROOK, BLACK) | pieces(QUEEN, BLACK)), empty, orthogonalShifts,
+                          orthogonalMasks),
+        koggeStoneAttacks(broadcast(pieces(BISHOP, BLACK) | pieces(QUEEN, BLACK)), empty, diagonalShifts,
+                          diagonalMasks));
+
+    return {orLanes(whiteSliders) | getPawnAttackingSquares<WHITE>(pieces(PAWN, WHITE)) |
+                knightAttacksSetwise(pieces(KNIGHT, WHITE)) | kingAttacksSetwise(pieces(KING, WHITE)),
+            orLanes(blackSliders) | getPawnAttackingSquares<BLACK>(pieces(PAWN, BLACK)) |
+                knightAttacksSetwise(pieces(KNIGHT, BLACK)) | kingAttacksSetwise(pieces(KING, BLACK))};
+}
+#endif
+
+template <AttackKernel Kernel>
+AttackMaps computeAttackMaps(const Position &board, Bitboard occupancy)
+{
+#ifdef __AVX2__
+    if constexpr (Kernel == AttackKernel::KOGGE_STONE)
+    {
+        return koggeStoneAttackMaps(board, occupancy);
+    }
+#endif
+    return {board.getAttackingSquares<WHITE>(occupancy), board.getAttackingSquares<BLACK>(occupancy)};
+}
+
 template <PieceKind Kind>
 Bitboard getPieceAttackingSquares(Bitboard allPieces, Bitboard pieces)
 {
@@ -850,21 +1468,15 @@ Bitboard getPieceAttackingSquares(Bitboard allPieces, Bitboard pieces)
         }
         else if constexpr (Kind == BISHOP)
         {
-            const Bitboard blockers = allPieces & BISHOP_BLOCKER_MASKS[index];
-            squares |= BISHOP_ATTACKING_SQUARES[index][blockers * BISHOP_MAGICS[index] >> BISHOP_SHIFTS[index]];
+            squares |= SLIDER_ATTACKS.bishopAttacks(index, allPieces);
         }
         else if constexpr (Kind == ROOK)
         {
-            const Bitboard blockers = allPieces & ROOK_BLOCKER_MASKS[index];
-            squares |= ROOK_ATTACKING_SQUARES[index][blockers * ROOK_MAGICS[index] >> ROOK_SHIFTS[index]];
+            squares |= SLIDER_ATTACKS.rookAttacks(index, allPieces);
         }
         else if constexpr (Kind == QUEEN)
         {
-            const Bitboard horizontalBlockers = allPieces & ROOK_BLOCKER_MASKS[index];
-            const Bitboard diagonalBlockers = allPieces & BISHOP_BLOCKER_MASKS[index];
-            const Bitboard horizontalSquares = ROOK_ATTACKING_SQUARES[index][(horizontalBlockers * ROOK_MAGICS[index]) >> ROOK_SHIFTS[index]];
-            const Bitboard diagonalSquares = BISHOP_ATTACKING_SQUARES[index][(diagonalBlockers * BISHOP_MAGICS[index]) >> BISHOP_SHIFTS[index]];
-            squares |= horizontalSquares | diagonalSquares;
+            squares |= SLIDER_ATTACKS.rookAttacks(index, allPieces) | SLIDER_ATTACKS.bishopAttacks(index, allPieces);
         }
         else if constexpr (Kind == KING)
         {
@@ -874,6 +1486,30 @@ Bitboard getPieceAttackingSquares(Bitboard allPieces, Bitboard pieces)
     return squares;
 }
 
+template MoveList generateLegalMoves<WHITE>(const Position &board);
+template MoveList generateLegalMoves<BLACK>(const Position &board);
+template void generateLegalMoves<WHITE>(const Position &board, MoveList &moves, GenerationMode mode);
+template void generateLegalMoves<BLACK>(const Position &board, MoveList &moves, GenerationMode mode);
+template void generateLegalMoves<WHITE>(const Position &board, CaptureList &moves, GenerationMode mode);
+template void generateLegalMoves<BLACK>(const Position &board, CaptureList &moves, GenerationMode mode);
+template void generateLegalMoves(const Position &board, MoveList &moves, GenerationMode mode);
+template void generateLegalMoves(const Position &board, CaptureList &moves, GenerationMode mode);
+template void generatePseudoLegalMoves(const Position &board, MoveList &moves, GenerationMode mode);
+template void generatePseudoLegalMoves(const Position &board, CaptureList &moves, GenerationMode mode);
+template size_t countLegalMoves<WHITE>(const Position &board);
+template size_t countLegalMoves<BLACK>(const Position &board);
+template CheckInfo computeCheckInfo<WHITE>(const Position &board);
+template CheckInfo computeCheckInfo<BLACK>(const Position &board);
+template AttackMaps computeAttackMaps<AttackKernel::LOOKUP>(const Position &board, Bitboard occupancy);
+#ifdef __AVX2__
+template AttackMaps computeAttackMaps<AttackKernel::KOGGE_STONE>(const Position &board, Bitboard occupancy);
+#endif
+template Bitboard rookAttacks<SliderIndexing::MAGIC>(Square square, Bitboard occupancy);
+template Bitboard bishopAttacks<SliderIndexing::MAGIC>(Square square, Bitboard occupancy);
+#ifdef __BMI2__
+template Bitboard rookAttacks<SliderIndexing::PEXT>(Square square, Bitboard occupancy);
+template Bitboard bishopAttacks<SliderIndexing::PEXT>(Square square, Bitboard occupancy);
+#endif
 template Bitboard getPieceAttackingSquares<PieceKind::KNIGHT>(Bitboard allPieces, Bitboard pieces);
 template Bitboard getPieceAttackingSquares<PieceKind::BISHOP>(Bitboard allPieces, Bitboard pieces);
 template Bitboard getPieceAttackingSquares<PieceKind::ROOK>(Bitboard allPieces, Bitboard pieces);
@@ -5,10 +5,96 @@
 #include "Piece.hpp"
 #include "bitboards.hpp"
 
-class Board;
+class Position;
+struct CheckInfo;
 
 namespace movegen
 {
+/**
+ * The kinds of legal moves to generate. Captures and quiets together are all legal moves, with promotions that don't
+ * capture anything counted as captures. Evasions are all legal moves, and should only be used when the side to move is
+ * in check, in which case castling and moves that don't resolve the check are never tried.
+ */
+enum class GenerationMode : uint8_t
+{
+    ALL,
+    CAPTURES,
+    QUIETS,
+    EVASIONS
+};
+
+/**
+ * How slider attacks are looked up: by multiplying the blockers by a magic number, or with the BMI2 PEXT instruction.
+ * PEXT is chosen at build time with USE_PEXT, and is usually faster on Intel CPUs and Zen 3 or later, but much slower
+ * on earlier AMD CPUs, where it is microcoded.
+ */
+enum class SliderIndexing : uint8_t
+{
+    MAGIC,
+    PEXT
+};
+
+#ifdef USE_PEXT
+#ifndef __BMI2__
+#error "USE_PEXT requires a target with BMI2, for example -mbmi2 or -march=native on a CPU that supports it"
+#endif
+constexpr SliderIndexing SLIDER_INDEXING = SliderIndexing::PEXT;
+#else
+constexpr SliderIndexing SLIDER_INDEXING = SliderIndexing::MAGIC;
+#endif
+
+/**
+ * How the squares attacked by both sides are computed for computeAttackMaps(): by looking up the attacks of each piece
+ * in the tables, or with an AVX2 kernel that fills the attacks of the sliders of both sides in all eight directions at
+ * once with Kogge-Stone fills, which doesn't loop over the pieces. Kogge-Stone is chosen at build time with
+ * USE_KOGGE_STONE, which also makes move generation and move counting use it for the squares the king can't move to,
+ * and benchAttackMaps() compares the two.
+ */
+enum class AttackKernel : uint8_t
+{
+    LOOKUP,
+    KOGGE_STONE
+};
+
+#ifdef USE_KOGGE_STONE
+#ifndef __AVX2__
+#error "USE_KOGGE_STONE requires a target with AVX2, for example -mavx2 or -march=native on a CPU that supports it"
+#endif
+constexpr AttackKernel ATTACK_KERNEL = AttackKernel::KOGGE_STONE;
+#else
+constexpr AttackKernel ATTACK_KERNEL = AttackKernel::LOOKUP;
+#endif
+
+/**
+ * Which moves the search generates: only legal moves, or pseudo-legal moves that may leave the king in check, which are
+ * checked with Position::isLegal() when they are about to be searched. Pseudo-legal generation skips the pins and the
+ * opponent's attack map, which is wasted on the moves after a beta cutoff. It is chosen at build time with
+ * USE_PSEUDO_LEGAL_MOVEGEN so that the two can be compared on search speed. Perft and everything outside the search
+ * always use legal generation.
+ */
+enum class MoveLegality : uint8_t
+{
+    LEGAL,
+    PSEUDO_LEGAL
+};
+
+#ifdef USE_PSEUDO_LEGAL_MOVEGEN
+constexpr MoveLegality SEARCH_MOVE_LEGALITY = MoveLegality::PSEUDO_LEGAL;
+#else
+constexpr MoveLegality SEARCH_MOVE_LEGALITY = MoveLegality::LEGAL;
+#endif
+
+/**
+ * Squares attacked by each side
+ */
+struct AttackMaps
+{
+    Bitboard white = 0;
+    Bitboard black = 0;
+
+    bool operator==(const AttackMaps &) const = default;
+};
+
 struct EdgeDistance
 {
     uint8_t WEST;
@@ -21,10 +107,76 @@ struct EdgeDistance
     uint8_t SOUTHEAST;
 };
 
-MoveList generateLegalMoves(Board &board);
+/**
+ * Generates the legal moves for the side to move, which must be Side. The side is a template parameter so that the
+ * colour dependent shifts and masks are constants, and generateLegalMoves(const Position &) dispatches to this.
+ */
+template <PieceColor Side>
+MoveList generateLegalMoves(const Position &board);
+MoveList generateLegalMoves(const Position &board);
+MoveList generateLegalMoves(const Position &board, GenerationMode mode);
+
+/**
+ * Adds the legal moves of the given mode to the end of a move list, so that moves of different modes can be generated
+ * into the same list when they are needed, and so that lists can be reused for each ply. Only captures can be generated
+ * into a CaptureList, and std::invalid_argument is thrown for any other mode.
+ */
+template <size_t Capacity>
+void generateLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode);
+template <PieceColor Side, size_t Capacity>
+void generateLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode);
+
+/**
+ * Adds the pseudo-legal moves of the given mode to the end of a move list. These are the legal moves plus moves of
+ * pinned pieces off their pin line, king moves to attacked squares, castling through attacked squares and en passant
+ * captures that expose the king, so every move must be checked with Position::isLegal() before it is made. Moves that
+ * don't resolve a check are still left out.
+ */
+template <size_t Capacity>
+void generatePseudoLegalMoves(const Position &board, BasicMoveList<Capacity> &moves, GenerationMode mode);
+/**
+ * Counts the legal moves for the side to move without generating them, by counting the squares each piece can move to.
+ * This is used for bulk counting at the leaves of perft, and can be used for mobility in the evaluation.
+ */
+template <PieceColor Side>
+size_t countLegalMoves(const Position &board);
+size_t countLegalMoves(const Position &board);
+template <PieceColor Side>
+CheckInfo computeCheckInfo(const Position &board);
+CheckInfo computeCheckInfo(const Position &board);
+bool givesCheck(const Position &board, Move move);
+template <PieceColor Side>
+constexpr Bitboard getPawnAttackingSquares(Bitboard pawns)
+{
+    if constexpr (Side == PieceColor::WHITE)
+    {
+        return ((pawns & ~bitboards::FILE_A) << 9) | ((pawns & ~bitboards::FILE_H) << 7);
+    }
+    else
+    {
+        return ((pawns & ~bitboards::FILE_A) >> 7) | ((pawns & ~bitboards::FILE_H) >> 9);
+    }
+}
+
 Bitboard getPawnAttackingSquares(Bitboard pawns, PieceColor side);
 template <PieceKind Kind>
 Bitboard getPieceAttackingSquares(Bitboard allPieces, Bitboard pieces);
+
+/**
+ * Squares attacked by a rook or bishop on the given square. The indexing can be chosen to compare the backends, but
+ * PEXT is only available when compiling for a target with BMI2.
+ */
+template <SliderIndexing Indexing = SLIDER_INDEXING>
+Bitboard rookAttacks(Square square, Bitboard occupancy);
+template <SliderIndexing Indexing = SLIDER_INDEXING>
+Bitboard bishopAttacks(Square square, Bitboard occupancy);
+
+/**
+ * Computes the squares attacked by both sides, with sliding pieces blocked by the given occupancy. The Kogge-Stone
+ * kernel is only available when compiling for a target with AVX2.
+ */
+template <AttackKernel Kernel = ATTACK_KERNEL>
+AttackMaps computeAttackMaps(const Position &board, Bitboard occupancy);
 std::array<EdgeDistance, 64> getEdgeDistances();
 
 std::array<Bitboard, 64> getBishopBlockerMasks();
@@ -1,8 +1,10 @@
 #include "search.hpp"
 #include "Board.hpp"
+#include "MovePicker.hpp"
 #include "Piece.hpp"
 #include "eval.hpp"
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -13,6 +15,10 @@ using std::vector;
 constexpr int POSITIVE_INFINITY = std::numeric_limits<int>::max() - 1;
 constexpr int NEGATIVE_INFINITY = std::numeric_limits<int>::min() + 1;
 constexpr size_t DEFAULT_TRANSPOSITION_TABLE_SIZE_MB = 10;
+// Null move pruning is only used when there is enough depth left for the reduced search to be worth doing
+constexpr uint8_t NULL_MOVE_MIN_DEPTH = 3;
+// Ply is stored in a uint8_t, so the search can never be deeper than this
+constexpr size_t MAX_PLY = 256;
 
 DebugStats debugStats{};
 
@@ -22,6 +28,12 @@ struct SearchState
     bool interruptSearch = false;
     std::optional<SearchResult> bestMove;
     int depth = 0; // Depth fully searched
+    size_t rootPly = 0; // Ply of the board at the root of the search, used for repetition detection
+    // The last two quiet moves that caused a beta cutoff at each ply, which are likely to cause a cutoff in sibling nodes
+    std::array<std::array<Move, 2>, MAX_PLY> killerMoves{};
+    // Moves of the node being searched at each ply, so that nodes don't need their own lists on the stack
+    std::array<MoveList, MAX_PLY> moveLists;
+    std::array<CaptureList, MAX_PLY> captureLists;
 };
 
 SearchState searchState;
@@ -51,7 +63,16 @@ struct TT_Entry
 };
 
 size_t ttNumEntries = DEFAULT_TRANSPOSITION_TABLE_SIZE_MB * 1000 * 1000 / sizeof(TT_Entry);
-vector<TT_Entry> transpositionTable{ttNumEntries};
+// Only allocated when it is first needed, so that starting the engine doesn't have to touch every page of the table
+vector<TT_Entry> transpositionTable;
+
+void allocateTranspositionTable()
+{
+    if (transpositionTable.size() != ttNumEntries)
+    {
+        transpositionTable.resize(ttNumEntries);
+    }
+}
 
 void resizeTranspositionTable(size_t sizeMB)
 {
@@ -60,6 +81,11 @@ void resizeTranspositionTable(size_t sizeMB)
     transpositionTable.resize(ttNumEntries);
 }
 
+void clearTranspositionTable()
+{
+    std::ranges::fill(transpositionTable, TT_Entry{});
+}
+
 size_t index(uint64_t hash)
 {
     return hash % ttNumEntries;
@@ -92,79 +118,30 @@ void storeTransposition(NodeKind kind, uint64_t hash, uint8_t depth, uint8_t ply
     transpositionTable.at(index(hash)) = {kind, hash, depth, eval, bestMove_};
 }
 
-int endgameMoveScore(Board &board, const Move &move)
+void storeKillerMove(uint8_t ply, Move move)
 {
-    int s = 0;
-    board.makeMove(move);
-    s = endgameEval(board) * (board.sideToMove == PieceColor::BLACK ? -1 : 1);
-    board.unmakeMove();
-    return s;
-}
-
-int moveScore(const Board &board, const Move &move)
-{
-    int score = 0;
-    // This won't be the case for en passant, but it's so rare that it's probably faster to do this without branching and possibly have a suboptimal move order with en passant moves (TODO: Benchmark)
-    const Piece capturedPiece = board[move.end()];
-
-    // Capturing a high value piece with a low value piece is likely to be a good move
-    if (!capturedPiece.isNone())
+    std::array<Move, 2> &killers = searchState.killerMoves[ply];
+    if (killers[0] != move)
     {
-        score += pieceValue(capturedPiece.kind());
+        killers[1] = killers[0];
+        killers[0] = move;
     }
-
-    if (move.isPromotion())
-    {
-        if (move.moveFlag() == MoveFlag::PromotionQueen)
-        {
-            score += QUEEN_VALUE;
-        }
-        else if (move.moveFlag() == MoveFlag::PromotionRook)
-        {
-            score += ROOK_VALUE;
-        }
-        else if (move.moveFlag() == MoveFlag::PromotionBishop)
-        {
-            score += BISHOP_VALUE;
-        }
-        else if (move.moveFlag() == MoveFlag::PromotionKnight)
-        {
-            score += KNIGHT_VALUE;
-        }
-    }
-
-    return score;
 }
 
-void orderMoves(Board &board, MoveList &moves)
+int qSearch(Board &board, uint8_t ply, int alpha, int beta);
+
+bool hasNonPawnMaterial(const Board &board, PieceColor side)
 {
-    for (Move &move : moves)
-    {
-        const auto ttEntry = getTransposition(board.getHash());
-        if (ttEntry != nullptr && !ttEntry->bestMoveInPosition.isInvalid() && ttEntry->bestMoveInPosition == move)
-        {
-            move.score = std::numeric_limits<int>::max();
-            continue;
-        }
-        if (whiteMaterial(board) + blackMaterial(board) < 1200)
-        {
-            move.score = endgameMoveScore(board, move);
-        }
-        else
-        {
-            move.score = moveScore(board, move);
-        }
-    }
-    std::ranges::sort(moves, [](const Move &m1, const Move &m2)
-                      { return m1.score > m2.score; });
+    using enum PieceKind;
+    return board.getPieceCount(Piece{KNIGHT, side}) + board.getPieceCount(Piece{BISHOP, side}) +
+               board.getPieceCount(Piece{ROOK, side}) + board.getPieceCount(Piece{QUEEN, side}) >
+           0;
 }
 
-int qSearch(Board &board, int alpha, int beta);
-
 // Alpha - lower bound, beta - upper bound
 // Anything less than alpha is useless because there's already a better line available
 // Beta is the worst possible score for the opponent, anything higher than beta will not be chosen by the opponent
-int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta)
+int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta, bool allowNullMove = true)
 {
     if (searchState.interruptSearch)
     {
@@ -172,7 +149,15 @@ int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta)
         return 0;
     }
 
+    if (board.isRepetitionInSearch(searchState.rootPly))
+    {
+        return 0;
+    }
+
     const TT_Entry *ttEntry = getTransposition(board.getHash());
+    // Copied straight away, because the entry can be replaced by a position searched below this one, including in the
+    // null move search
+    const Move ttMove = ttEntry != nullptr ? ttEntry->bestMoveInPosition : Move{};
     if (ttEntry != nullptr)
     {
         if (ttEntry->depth >= depth)
@@ -201,18 +186,50 @@ int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta)
     if (depth == 0)
     {
         // TODO: Store in TT? (depends on eval function complexity)
-        return qSearch(board, alpha, beta);
+        return qSearch(board, ply, alpha, beta);
     }
 
-    MoveList moves = board.getLegalMoves();
-    orderMoves(board, moves);
+    /*
+    Null move pruning: if the side to move would still be above beta after passing the turn to the opponent, a real move
+    will almost certainly be too, so a reduced search of the null move is enough to cut this node off. This is wrong in
+    zugzwang, where passing would be better than any legal move, which is mostly the case in pawn endgames, so it is
+    only done when the side to move has pieces other than pawns. Two null moves are never made in a row, because that
+    would just be the same position searched at a lower depth.
+     */
+    if (allowNullMove && depth >= NULL_MOVE_MIN_DEPTH && !board.isSideInCheck(board.sideToMove) &&
+        hasNonPawnMaterial(board, board.sideToMove) && staticEval(board) >= beta)
+    {
+        const uint8_t reduction = std::min<uint8_t>(2 + depth / 6, depth - 1);
+        board.makeNullMove();
+        const int nullMoveEval = -evaluate(board, depth - 1 - reduction, ply + 1, -beta, -beta + 1, false);
+        board.unmakeNullMove();
+        if (nullMoveEval >= beta)
+        {
+            return beta;
+        }
+    }
+
+    // Checkmates closer to the root are better, so they should have a lower score (a lower score for the losing side is better for the other side)
+    // Not doing this causes the engine to make draws and not play the best move, even if it knows that it
+    // can be played.
+    const int mateEval = NEGATIVE_INFINITY + ply;
+
+    // Don't store these in TT since they are easy to compute (TODO: Benchmark this)
+    // Checkmate takes priority over the other draws, but generating moves to check for it is only needed here
+    if (board.isDrawByFiftyMoveRule() || board.isInsufficientMaterial())
+    {
+        return board.isSideInCheck(board.sideToMove) && board.getLegalMoves().empty() ? mateEval : 0;
+    }
 
     // Assume that no moves will exceed alpha.
     NodeKind nodeKind = NodeKind::UPPER_BOUND;
     Move bestMove_{0, 0, MoveFlag::None};
 
-    for (const Move move : moves)
+    MovePicker movePicker{board, searchState.moveLists[ply], ttMove, searchState.killerMoves[ply]};
+    int movesSearched = 0;
+    for (Move move = movePicker.next(); !move.isInvalid(); move = movePicker.next())
     {
+        movesSearched++;
         board.makeMove(move);
         /*
         Swap alpha and beta because the maximising player is now the minimising player and vice versa.
@@ -229,7 +246,12 @@ int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta)
             // (there is a move the opponent can play to avoid this position, so this move will never be played)
             // This is a lower bound on the true eval because we are exiting the search early and there may be other
             // moves we haven't searched which may be better.
-            storeTransposition(NodeKind::LOWER_BOUND, board.getHash(), depth, ply, beta, bestMove_);
+            if (isQuiet(board, move))
+            {
+                storeKillerMove(ply, move);
+            }
+            // The move that caused the cutoff is the one to try first when this position is searched again
+            storeTransposition(NodeKind::LOWER_BOUND, board.getHash(), depth, ply, beta, move);
             return beta;
         }
         if (eval > alpha)
@@ -243,32 +265,18 @@ int evaluate(Board &board, uint8_t depth, uint8_t ply, int alpha, int beta)
         // The eval will be an upper bound because we don't know exactly how much worse this node is than the best possible node, only that it's worse (at most alpha).
     }
 
-    if (moves.empty())
+    if (movesSearched == 0)
     {
-        // Don't store these in TT since they are easy to compute (TODO: Benchmark this)
-        if (board.isDraw())
-        {
-            return 0;
-        }
-        if (board.isSideInCheck(board.sideToMove))
-        {
-            // Checkmates closer to the root are better, so they should have a lower score (a lower score for the losing side is better for the other side)
-            // Not doing this causes the engine to make draws and not play the best move, even if it knows that it
-            // can be played.
-            int mateEval = NEGATIVE_INFINITY + ply;
-            return mateEval;
-        }
+        return board.isSideInCheck(board.sideToMove) ? mateEval : 0;
     }
 
-    if (nodeKind == NodeKind::EXACT)
-    {
-        storeTransposition(nodeKind, board.getHash(), depth, ply, alpha, bestMove_);
-    }
+    // No move raised alpha at an upper bound node, so the previous TT move (if any) is kept as the move to try first
+    storeTransposition(nodeKind, board.getHash(), depth, ply, alpha, nodeKind == NodeKind::EXACT ? bestMove_ : ttMove);
     return alpha;
 }
 
 // Continues the search until a "quiet" position is reached (no possible captures)
-int qSearch(Board &board, int alpha, int beta)
+int qSearch(Board &board, uint8_t ply, int alpha, int beta)
 {
     if (searchState.interruptSearch)
     {
@@ -283,13 +291,11 @@ int qSearch(Board &board, int alpha, int beta)
     }
     alpha = std::max(alpha, eval);
 
-    MoveList captures = board.getLegalCaptures();
-    orderMoves(board, captures);
-
-    for (const Move move : captures)
+    MovePicker movePicker{board, searchState.captureLists[ply]};
+    for (Move move = movePicker.next(); !move.isInvalid(); move = movePicker.next())
     {
         board.makeMove(move);
-        eval = -qSearch(board, -beta, -alpha);
+        eval = -qSearch(board, ply + 1, -beta, -alpha);
         board.unmakeMove();
 
         if (eval >= beta)
@@ -304,7 +310,9 @@ int qSearch(Board &board, int alpha, int beta)
 
 SearchResult bestMove(Board &board, uint8_t depth)
 {
+    allocateTranspositionTable();
     debugStats = DebugStats{};
+    searchState.rootPly = board.getPly();
     MoveList moves = board.getLegalMoves();
 
     // TODO: This will crash if there are no legal moves (mate/stalemate)
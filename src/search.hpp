@@ -33,7 +33,13 @@ struct SearchResult
     }
 };
 
+/**
+ * Allocates the transposition table if it hasn't been allocated yet. This is done by the first search, or earlier by
+ * calling this (for example when the GUI sends isready) so that the first search doesn't pay for it.
+ */
+void allocateTranspositionTable();
 void resizeTranspositionTable(size_t sizeMB);
+void clearTranspositionTable();
 
 SearchResult bestMove(Board &board, uint8_t depth);
 SearchResult timeLimitedSearch(Board &board, std::chrono::milliseconds timeLimit);
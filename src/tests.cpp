@@ -1,33 +1,112 @@
 #include "tests.hpp"
 #include "Board.hpp"
 #include "Move.hpp"
+#include "PerftCache.hpp"
+#include "epd.hpp"
+#include "eval.hpp"
+#include "movegen.hpp"
 #include "utils.hpp"
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <utility>
 
-int passedTests = 0;
-int failedTests = 0;
+// Updated from every thread that runs tests
+std::atomic<int> passedTests = 0;
+std::atomic<int> failedTests = 0;
 
-size_t perft(Board &board, uint8_t depth, bool rootNode = true, bool output = true)
+/**
+ * Calls the function with every index below count on a pool of threads, where each thread takes the next index when it
+ * finishes one, so that uneven amounts of work are still spread over every thread
+ */
+template <typename Function>
+void parallelFor(size_t count, unsigned int threadCount, Function &&function)
+{
+    std::atomic<size_t> nextIndex = 0;
+    std::vector<std::thread> threads;
+    threadCount = static_cast<unsigned int>(std::clamp<size_t>(count, 1, std::max(threadCount, 1u)));
+    threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([&]
+                             {
+                                 for (size_t index = nextIndex++; index < count; index = nextIndex++)
+                                 {
+                                     function(index);
+                                 } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * State of one call to perft(), which is only used by the thread making the call
+ */
+struct PerftContext
+{
+    // One list for each remaining depth, reused by every node at that depth
+    std::vector<MoveList> moveLists;
+    PerftCache *cache;
+    // Counted by each thread and added to the cache's totals at the end, so that probing the shared cache doesn't write
+    // to it
+    size_t cacheProbes = 0;
+    size_t cacheHits = 0;
+};
+
+/**
+ * Perft for a known side to move, so that move generation and making moves don't dispatch on the side at every node.
+ * The moves at each remaining depth are generated into the move list for that depth.
+ */
+template <PieceColor Side>
+size_t perft(Board &board, uint8_t depth, bool rootNode, bool output, PerftContext &context)
 {
     size_t positionsReached = 0;
 
-    // If running perft(1), print the full move list for debugging purposes
+    // If running perft(1), print the full move list for debugging purposes. Otherwise the leaves are only counted.
     if (depth == 1 && !rootNode)
     {
-        return board.getLegalMoves().size();
+        return board.countLegalMoves<Side>();
     }
     if (depth == 0)
     {
         return 1;
     }
 
-    for (Move move : board.getLegalMoves())
+    // Leaves are counted faster than the cache can be probed, so only deeper subtrees are cached. The root isn't cached
+    // because its moves may need to be printed.
+    const bool useCache = context.cache != nullptr && !rootNode;
+    uint64_t hash = 0;
+    if (useCache)
     {
-        board.makeMove(move);
+        hash = board.getHash();
+        context.cacheProbes++;
+        if (const std::optional<size_t> cached = context.cache->probe(hash, depth))
+        {
+            context.cacheHits++;
+            return *cached;
+        }
+    }
 
-        const size_t result = perft(board, depth - 1, false);
+    MoveList &moves = context.moveLists[depth];
+    moves.clear();
+    movegen::generateLegalMoves<Side>(board, moves, movegen::GenerationMode::ALL);
+    for (Move move : moves)
+    {
+        board.makeMove<Side>(move);
+
+        const size_t result = perft<oppositeColor(Side)>(board, depth - 1, false, false, context);
         positionsReached += result;
 
         if (rootNode && output)
@@ -38,10 +117,55 @@ size_t perft(Board &board, uint8_t depth, bool rootNode = true, bool output = tr
         board.unmakeMove();
     }
 
+    if (useCache)
+    {
+        context.cache->store(hash, depth, positionsReached);
+    }
     return positionsReached;
 }
 
-size_t runPerft(uint8_t depth, const std::string &fen, const std::string &moveSequence)
+size_t perft(Board &board, uint8_t depth, bool rootNode, bool output, PerftCache *cache)
+{
+    PerftContext context{std::vector<MoveList>(depth + 1), cache};
+    const size_t positionsReached = board.sideToMove == PieceColor::WHITE
+                                        ? perft<PieceColor::WHITE>(board, depth, rootNode, output, context)
+                                        : perft<PieceColor::BLACK>(board, depth, rootNode, output, context);
+    if (cache != nullptr)
+    {
+        cache->addProbes(context.cacheProbes, context.cacheHits);
+    }
+    return positionsReached;
+}
+
+size_t parallelPerft(Board &board, uint8_t depth, unsigned int threadCount, bool output, PerftCache *cache)
+{
+    if (depth == 0)
+    {
+        return 1;
+    }
+    const MoveList rootMoves = board.getLegalMoves();
+    std::vector<size_t> results(rootMoves.size());
+    parallelFor(rootMoves.size(), threadCount, [&](size_t i)
+                {
+                    // Copying a board only copies the plies that have been played, and each root move needs its own
+                    Board threadBoard = board;
+                    threadBoard.makeMove(rootMoves[i]);
+                    results[i] = perft(threadBoard, depth - 1, false, false, cache); });
+
+    size_t positionsReached = 0;
+    for (size_t i = 0; i < rootMoves.size(); i++)
+    {
+        positionsReached += results[i];
+        if (output)
+        {
+            std::cout << static_cast<std::string>(rootMoves[i]) << ": " << results[i] << "\n";
+        }
+    }
+    return positionsReached;
+}
+
+size_t runPerft(uint8_t depth, const std::string &fen, const std::string &moveSequence, unsigned int threadCount,
+                size_t cacheSizeMB)
 {
     Board board;
     board.loadFen(fen);
@@ -61,89 +185,774 @@ size_t runPerft(uint8_t depth, const std::string &fen, const std::string &moveSe
         }
     }
 
+    std::unique_ptr<PerftCache> cache = cacheSizeMB == 0 ? nullptr : std::make_unique<PerftCache>(cacheSizeMB);
     std::map<std::string, size_t> moveCounts;
     auto start = std::chrono::system_clock::now();
-    size_t total = perft(board, depth);
+    size_t total = threadCount > 1 ? parallelPerft(board, depth, threadCount, true, cache.get())
+                                   : perft(board, depth, true, true, cache.get());
     auto end = std::chrono::system_clock::now();
     std::cout << total << " positions reached in " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "\n";
+    if (cache != nullptr)
+    {
+        std::cout << "cache hits: " << cache->hits() << " of " << cache->probes() << " probes ("
+                  << cache->hitRate() * 100 << "%)\n";
+    }
 
     return total;
 }
 
-void test(uint8_t depth, const std::string &fen, size_t expectedValue)
+size_t test(uint8_t depth, const std::string &fen, size_t expectedValue, std::ostream &out, PerftCache *cache)
 {
     Board board;
     board.loadFen(fen);
-    size_t total = perft(board, depth, false);
-    std::cout << "test " << fen << " ";
+    const auto start = std::chrono::steady_clock::now();
+    size_t total = perft(board, depth, false, true, cache);
+    const auto time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    out << (cache == nullptr ? "test " : "cached test ") << fen << " ";
     if (total == expectedValue)
     {
-        std::cout << "PASSED (" << total << ")";
+        out << "PASSED (" << total << ")";
+        passedTests++;
+    }
+    else
+    {
+        out << "FAILED (expected " << expectedValue << " actual " << total << ")";
+        failedTests++;
+    }
+    out << " in " << time.count() << " ms\n";
+    return total;
+}
+
+void testConcurrentPerft(uint8_t depth, const std::string &fen, unsigned int threadCount)
+{
+    Board board;
+    board.loadFen(fen);
+    const size_t expectedValue = perft(board, depth, false);
+
+    std::vector<size_t> results(threadCount);
+    std::vector<std::thread> threads;
+    threads.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; i++)
+    {
+        threads.emplace_back([&, i]
+                             {
+                                 // Each thread has its own board, so only the move generator is shared
+                                 Board threadBoard;
+                                 threadBoard.loadFen(fen);
+                                 results[i] = perft(threadBoard, depth, false, false); });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+
+    const auto mismatches = std::ranges::count_if(results, [&](size_t result)
+                                                  { return result != expectedValue; });
+    std::cout << "concurrent perft " << fen << " ";
+    if (mismatches == 0)
+    {
+        std::cout << "PASSED (" << threadCount << " x " << expectedValue << ")";
         passedTests++;
     }
     else
     {
-        std::cout << "FAILED (expected " << expectedValue << " actual " << total
+        std::cout << "FAILED (" << mismatches << " of " << threadCount << " threads did not get " << expectedValue
                   << ")";
         failedTests++;
     }
     std::cout << "\n";
 }
 
-void runTests()
+void testMoveValidation(const std::string &fen, std::ostream &out)
 {
-    passedTests = 0;
-    failedTests = 0;
-    // TODO: Multithreading
-    test(6, STARTING_POSITION_FEN, 119060324);
+    constexpr int GAMES = 20;
+    constexpr int MAX_PLIES = 60;
+    constexpr int RANDOM_MOVES_PER_POSITION = 64;
+
+    Board board;
+    board.loadFen(fen);
+    // Fixed seed so that failures can be reproduced
+    std::mt19937 rng{static_cast<uint32_t>(std::hash<std::string>{}(fen))};
+    std::uniform_int_distribution<int> squareDistribution{0, 63};
+    std::uniform_int_distribution<int> flagDistribution{0, 7};
+
+    size_t movesChecked = 0;
+    size_t mismatches = 0;
+    MoveList previousMoves;
+
+    const auto check = [&](Move move, MoveList &legalMoves)
+    {
+        const bool expected = std::ranges::find(legalMoves, move) != legalMoves.end();
+        const bool actual = board.isPseudoLegal(move) && board.isLegal(move);
+        movesChecked++;
+        if (expected != actual)
+        {
+            if (mismatches == 0)
+            {
+                out << "move validation mismatch for " << static_cast<std::string>(move) << " in "
+                    << board.getFen() << " (expected " << expected << ")\n";
+            }
+            mismatches++;
+        }
+    };
+
+    for (int game = 0; game < GAMES; game++)
+    {
+        for (int ply = 0; ply < MAX_PLIES; ply++)
+        {
+            MoveList legalMoves = board.getLegalMoves();
+            // Every generated move must be accepted, and moves from the previous position are likely to be close to
+            // legal, like a killer move or a hash move after a collision would be
+            for (const Move move : legalMoves)
+            {
+                check(move, legalMoves);
+            }
+            for (const Move move : previousMoves)
+            {
+                check(move, legalMoves);
+            }
+            for (int i = 0; i < RANDOM_MOVES_PER_POSITION; i++)
+            {
+                const Move move{static_cast<Square>(squareDistribution(rng)), static_cast<Square>(squareDistribution(rng)),
+                                static_cast<MoveFlag>(flagDistribution(rng))};
+                check(move, legalMoves);
+            }
+
+            if (legalMoves.empty())
+            {
+                break;
+            }
+            previousMoves = legalMoves;
+            std::uniform_int_distribution<size_t> moveDistribution{0, legalMoves.size() - 1};
+            board.makeMove(legalMoves[moveDistribution(rng)]);
+        }
+        while (board.getPly() > 0)
+        {
+            board.unmakeMove();
+        }
+    }
+
+    out << "move validation " << fen << " ";
+    if (mismatches == 0)
+    {
+        out << "PASSED (" << movesChecked << ")";
+        passedTests++;
+    }
+    else
+    {
+        out << "FAILED (" << mismatches << " of " << movesChecked << " moves)";
+        failedTests++;
+    }
+    out << "\n";
+}
+
+/**
+ * Result of checking a predicate in every position of a perft tree
+ */
+struct TreeCheck
+{
+    size_t positionsChecked = 0;
+    size_t mismatches = 0;
+    // FEN of the first position where the predicate failed, which is printed with the result
+    std::string firstMismatchFen;
+};
+
+/**
+ * Calls the predicate in every position of the perft tree of the board to the given depth, where depth 0 is only the
+ * current position, and counts the positions where it returns false
+ */
+template <typename Predicate>
+TreeCheck forEachPerftNode(Board &board, uint8_t depth, Predicate &&predicate)
+{
+    TreeCheck check;
+    check.positionsChecked = 1;
+    if (!predicate(board))
+    {
+        check.mismatches = 1;
+        check.firstMismatchFen = board.getFen();
+    }
+    if (depth > 0)
+    {
+        for (const Move move : board.getLegalMoves())
+        {
+            board.makeMove(move);
+            TreeCheck childCheck = forEachPerftNode(board, depth - 1, predicate);
+            board.unmakeMove();
+            if (check.mismatches == 0)
+            {
+                check.firstMismatchFen = std::move(childCheck.firstMismatchFen);
+            }
+            check.positionsChecked += childCheck.positionsChecked;
+            check.mismatches += childCheck.mismatches;
+        }
+    }
+    return check;
+}
+
+/**
+ * Prints the result of a tree check as a test, with the first position where it failed
+ */
+void reportTreeCheck(const std::string &label, const std::string &fen, const TreeCheck &check, std::ostream &out)
+{
+    if (check.mismatches != 0)
+    {
+        out << label << " mismatch in " << check.firstMismatchFen << "\n";
+    }
+    out << label << " " << fen << " ";
+    if (check.mismatches == 0)
+    {
+        out << "PASSED (" << check.positionsChecked << ")";
+        passedTests++;
+    }
+    else
+    {
+        out << "FAILED (" << check.mismatches << " of " << check.positionsChecked << " positions)";
+        failedTests++;
+    }
+    out << "\n";
+}
+
+/**
+ * Whether givesCheck() agrees with making each legal move and checking whether the opponent is in check
+ */
+bool givesCheckMatches(Board &board)
+{
+    for (const Move move : board.getLegalMoves())
+    {
+        const bool expected = board.givesCheck(move);
+        board.makeMove(move);
+        const bool isCheck = board.isSideInCheck(board.sideToMove);
+        board.unmakeMove();
+        if (isCheck != expected)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void testGivesCheck(uint8_t depth, const std::string &fen, std::ostream &out)
+{
+    Board board;
+    board.loadFen(fen);
+    // Every move of a position is checked, so the tree stops one ply before the given depth
+    const uint8_t positionDepth = std::max<uint8_t>(depth, 1) - 1;
+    reportTreeCheck("givesCheck", fen, forEachPerftNode(board, positionDepth, givesCheckMatches), out);
+}
+
+/**
+ * Whether the captures and quiet generation modes split the legal moves between them, evasions are the same as all
+ * legal moves when in check, counting the legal moves agrees with generating them, and filtering the pseudo-legal moves
+ * of each mode with isLegal() gives its legal moves
+ */
+bool generationModesMatch(Board &board)
+{
+    using movegen::GenerationMode;
+    MoveList allMoves = board.getLegalMoves();
+    MoveList captures = movegen::generateLegalMoves(board, GenerationMode::CAPTURES);
+    MoveList quiets = movegen::generateLegalMoves(board, GenerationMode::QUIETS);
+
+    const auto isLegal = [&](Move move)
+    {
+        return std::ranges::find(allMoves, move) != allMoves.end();
+    };
+    const auto isQuiet = [&](Move move)
+    {
+        return board.isSquareEmpty(move.end()) && move.moveFlag() != MoveFlag::EnPassant && !move.isPromotion();
+    };
+    bool matches = captures.size() + quiets.size() == allMoves.size() && board.countLegalMoves() == allMoves.size() &&
+                   std::ranges::all_of(captures, [&](Move move)
+                                       { return isLegal(move) && !isQuiet(move); }) &&
+                   std::ranges::all_of(quiets, [&](Move move)
+                                       { return isLegal(move) && isQuiet(move); });
+    if (board.isSideInCheck(board.sideToMove))
+    {
+        MoveList evasions = movegen::generateLegalMoves(board, GenerationMode::EVASIONS);
+        matches = matches && evasions.size() == allMoves.size() && std::ranges::all_of(evasions, isLegal);
+    }
+    // The pseudo-legal moves of each mode that isLegal() accepts must be exactly the legal moves of that mode
+    const auto matchesPseudoLegal = [&](GenerationMode mode, const MoveList &legalMoves)
+    {
+        MoveList pseudoLegalMoves;
+        movegen::generatePseudoLegalMoves(board, pseudoLegalMoves, mode);
+        size_t legalCount = 0;
+        for (const Move move : pseudoLegalMoves)
+        {
+            if (!board.isPseudoLegal(move))
+            {
+                return false;
+            }
+            if (board.isLegal(move))
+            {
+                if (std::ranges::find(legalMoves, move) == legalMoves.end())
+                {
+                    return false;
+                }
+                legalCount++;
+            }
+        }
+        return legalCount == legalMoves.size();
+    };
+    return matches && matchesPseudoLegal(GenerationMode::ALL, allMoves) &&
+           matchesPseudoLegal(GenerationMode::CAPTURES, captures) && matchesPseudoLegal(GenerationMode::QUIETS, quiets);
+}
+
+void testGenerationModes(uint8_t depth, const std::string &fen, std::ostream &out)
+{
+    Board board;
+    board.loadFen(fen);
+    reportTreeCheck("generation modes", fen, forEachPerftNode(board, depth, generationModesMatch), out);
+}
+
+/**
+ * Whether the incrementally updated hash is the same as the hash computed from scratch
+ */
+bool hashMatches(Board &board)
+{
+    return board.getHash() == board.hash();
+}
+
+void testHash(uint8_t depth, const std::string &fen, std::ostream &out)
+{
+    Board board;
+    board.loadFen(fen);
+    reportTreeCheck("hash", fen, forEachPerftNode(board, depth, hashMatches), out);
+}
+
+/**
+ * Whether attackersTo() agrees with isSquareAttacked() for every square and both sides, with the full occupancy and
+ * without the king of the side to move
+ */
+bool attackersToMatches(Board &board)
+{
+    const Bitboard occupancy = board.getPieces();
+    const Bitboard occupancyWithoutKing = occupancy & ~bitboards::withSquare(board.getKingSquare(board.sideToMove));
+    for (Square square = 0; square < 64; square++)
+    {
+        for (const PieceColor side : {PieceColor::WHITE, PieceColor::BLACK})
+        {
+            for (const Bitboard o : {occupancy, occupancyWithoutKing})
+            {
+                const Bitboard attackers = board.attackersTo(square, o) & board.getPieces(side) & o;
+                if ((attackers != 0) != board.isSquareAttacked(square, side, o, ~o))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+void testAttackersTo(uint8_t depth, const std::string &fen, std::ostream &out)
+{
+    Board board;
+    board.loadFen(fen);
+    reportTreeCheck("attackersTo", fen, forEachPerftNode(board, depth, attackersToMatches), out);
+}
+
+struct SeeTestPosition
+{
+    std::string fen;
+    std::string move;
+    int expectedValue;
+};
+
+const std::vector<SeeTestPosition> SEE_TEST_POSITIONS = {
+    // Undefended pawn
+    {"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", PAWN_VALUE},
+    // Knight takes a pawn and the exchange continues with the rook and queens behind the first attackers
+    {"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", PAWN_VALUE - KNIGHT_VALUE},
+    // The rook behind the first rook wins the exchange
+    {"3r2k1/8/8/3p4/8/8/3R4/3R2K1 w - - 0 1", "d2d5", PAWN_VALUE},
+    // Without the second rook, taking the pawn loses the rook
+    {"3r2k1/8/8/3p4/8/8/3R4/6K1 w - - 0 1", "d2d5", PAWN_VALUE - ROOK_VALUE},
+    // The king recaptures an undefended rook
+    {"8/8/8/8/4k3/3p4/8/3R2K1 w - - 0 1", "d1d3", PAWN_VALUE - ROOK_VALUE},
+    // The bishop defends the rook, so the king can't recapture
+    {"8/8/8/8/4k3/3p4/8/1B1R2K1 w - - 0 1", "d1d3", PAWN_VALUE},
+    // En passant
+    {"4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6", PAWN_VALUE},
+    // Capturing with a promotion, and the knight recaptures the queen
+    {"1r2k3/P2n4/8/8/8/8/8/4K3 w - - 0 1", "a7b8q", ROOK_VALUE + QUEEN_VALUE - PAWN_VALUE - QUEEN_VALUE},
+    // Capturing with a promotion that can't be recaptured
+    {"1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1", "a7b8q", ROOK_VALUE + QUEEN_VALUE - PAWN_VALUE},
+    // The pawn recaptures the rook by promoting
+    {"1Nr1k3/P7/8/8/8/8/8/4K3 b - - 0 1", "c8b8", KNIGHT_VALUE - ROOK_VALUE - (QUEEN_VALUE - PAWN_VALUE)},
+};
+
+void testSee(std::ostream &out)
+{
+    for (const SeeTestPosition &position : SEE_TEST_POSITIONS)
+    {
+        Board board;
+        board.loadFen(position.fen);
+        const int value = board.see(Move{board, position.move});
+        out << "see " << position.fen << " " << position.move << " ";
+        if (value == position.expectedValue)
+        {
+            out << "PASSED";
+            passedTests++;
+        }
+        else
+        {
+            out << "FAILED (expected " << position.expectedValue << ", got " << value << ")";
+            failedTests++;
+        }
+        out << "\n";
+    }
+}
+
+struct FenParsingTestCase
+{
+    std::string text;
+    bool isEpd;
+    // The placement, side to move, castling and en passant fields of the loaded position, or empty if the text must be
+    // rejected
+    std::string expectedFields;
+};
+
+const std::vector<FenParsingTestCase> FEN_PARSING_TEST_CASES = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", false,
+     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"},
+    // The clocks may be omitted
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -", false,
+     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"},
+    {"4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1", false, "4k3/8/8/8/4P3/8/8/4K3 b - e3"},
+    // Rights whose king or rook isn't on its home square are dropped
+    {"4k3/8/8/8/8/8/8/4K3 w KQkq - 0 1", false, "4k3/8/8/8/8/8/8/4K3 w - -"},
+    {"r3k3/8/8/8/8/8/8/4K2R w KQkq - 0 1", false, "r3k3/8/8/8/8/8/8/4K2R w Kq -"},
+    {"r3k2r/8/8/8/8/8/8/R4K1R w KQkq - 0 1", false, "r3k2r/8/8/8/8/8/8/R4K1R w kq -"},
+    // Rows without separators
+    {"rnbqkbnrpppppppp8888PPPPPPPPRNBQKBNR w KQkq - 0 1", false, ""},
+    {"rnbqkbnrpppppppp8888PPPPPPPPRNBQKBNR w KQxz e5 0 1 trailing junk", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3/8 w - - 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K2 w - - 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8//4K3 w - - 0 1", false, ""},
+    {"4k3/8/9/8/8/8/8/4K3 w - - 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4X3 w - - 0 1", false, ""},
+    // Missing king
+    {"8/8/8/8/8/8/8/4K3 w - - 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 x - - 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w", false, ""},
+    {"r3k2r/8/8/8/8/8/8/R3K2R w KQxz - 0 1", false, ""},
+    {"r3k2r/8/8/8/8/8/8/R3K2R w KK - 0 1", false, ""},
+    {"r3k2r/8/8/8/8/8/8/R3K2R w K- - 0 1", false, ""},
+    // The en passant square must be behind a pawn of the side that just moved
+    {"4k3/8/8/8/4P3/8/8/4K3 b - e6 0 1", false, ""},
+    {"4k3/8/8/4p3/8/8/8/4K3 w - e3 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w - i6 0 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 256 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w - - x 1", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 0 x", false, ""},
+    {"4k3/8/8/8/8/8/8/4K3 w - - 0 1 junk", false, ""},
+    {"", false, ""},
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - bm e4; id \"start\";", true,
+     "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"},
+    {"4k3/8/8/8/8/8/8/4K3 w KQkq -", true, "4k3/8/8/8/8/8/8/4K3 w - -"},
+    // EPD has no clocks, so the en passant field can't be left out
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq", true, ""},
+    {"rnbqkbnrpppppppp8888PPPPPPPPRNBQKBNR w KQkq - bm e4;", true, ""},
+};
+
+void testFenParsing(std::ostream &out)
+{
+    for (const FenParsingTestCase &testCase : FEN_PARSING_TEST_CASES)
+    {
+        std::string fields;
+        try
+        {
+            Position position;
+            if (testCase.isEpd)
+            {
+                position.loadEpd(testCase.text);
+            }
+            else
+            {
+                position.loadFen(testCase.text);
+            }
+            Board board;
+            board.loadPosition(position);
+            // Leave out the clocks, which EPD doesn't have
+            const std::string fen = board.getFen();
+            size_t end = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                end = fen.find(' ', end + 1);
+            }
+            fields = fen.substr(0, end);
+        }
+        catch (const std::invalid_argument &)
+        {
+        }
+
+        out << (testCase.isEpd ? "epd \"" : "fen \"") << testCase.text << "\" ";
+        if (fields == testCase.expectedFields)
+        {
+            out << "PASSED";
+            passedTests++;
+        }
+        else
+        {
+            out << "FAILED (expected " << (testCase.expectedFields.empty() ? "an error" : testCase.expectedFields)
+                << ", got " << (fields.empty() ? "an error" : fields) << ")";
+            failedTests++;
+        }
+        out << "\n";
+    }
+}
+
+struct EpdOperationTestCase
+{
+    std::string operations;
+    std::string opcode;
+    std::string expectedOperand;
+};
+
+const std::vector<EpdOperationTestCase> EPD_OPERATION_TEST_CASES = {
+    {"bm e4; id \"test 1\";", "bm", "e4"},
+    {"bm e4; id \"test 1\";", "id", "test 1"},
+    {"bm e4 d4;", "bm", "e4 d4"},
+    // Semicolons inside quotes don't end the operation
+    {"id \"a; b\"; bm Nf3;", "id", "a; b"},
+    {"id \"a; b\"; bm Nf3;", "bm", "Nf3"},
+    {"c0 \"no semicolon\"", "c0", "no semicolon"},
+    {"  bm   e4  ;  id x;", "bm", "e4"},
+    // Opcodes must match exactly
+    {"bmx e4; bm d4;", "bm", "d4"},
+    {"bm e4;", "b", ""},
+    {"bm e4;", "id", ""},
+    {";;", "bm", ""},
+    {"", "bm", ""},
+};
+
+void testEpdOperation(std::ostream &out)
+{
+    for (const EpdOperationTestCase &testCase : EPD_OPERATION_TEST_CASES)
+    {
+        const std::string_view operand = epdOperation(testCase.operations, testCase.opcode);
+        out << "epdOperation \"" << testCase.operations << "\" " << testCase.opcode << " ";
+        if (operand == testCase.expectedOperand)
+        {
+            out << "PASSED";
+            passedTests++;
+        }
+        else
+        {
+            out << "FAILED (expected \"" << testCase.expectedOperand << "\", got \"" << operand << "\")";
+            failedTests++;
+        }
+        out << "\n";
+    }
+}
+
+struct EpdFileTestCase
+{
+    std::string description;
+    std::string contents;
+    unsigned int threadCount;
+    // The ids of the loaded entries in order, or nothing if loading must fail
+    std::optional<std::vector<std::string>> expectedIds;
+};
+
+const std::string EPD_TEST_LINE = "4k3/8/8/8/8/8/8/4K3 w - - id ";
+
+const std::vector<EpdFileTestCase> EPD_FILE_TEST_CASES = {
+    {"one thread", EPD_TEST_LINE + "a;\n" + EPD_TEST_LINE + "b;\n" + EPD_TEST_LINE + "c;\n", 1,
+     std::vector<std::string>{"a", "b", "c"}},
+    {"more threads than lines", EPD_TEST_LINE + "a;\n" + EPD_TEST_LINE + "b;\n" + EPD_TEST_LINE + "c;\n", 8,
+     std::vector<std::string>{"a", "b", "c"}},
+    {"no trailing newline", EPD_TEST_LINE + "a;\n" + EPD_TEST_LINE + "b;\n" + EPD_TEST_LINE + "c;", 2,
+     std::vector<std::string>{"a", "b", "c"}},
+    {"single line on several threads", EPD_TEST_LINE + "a;", 4, std::vector<std::string>{"a"}},
+    {"CRLF", EPD_TEST_LINE + "a;\r\n" + EPD_TEST_LINE + "b;\r\n" + EPD_TEST_LINE + "c;\r\n", 3,
+     std::vector<std::string>{"a", "b", "c"}},
+    {"blank lines", "\n\n" + EPD_TEST_LINE + "a;\n\r\n  \n" + EPD_TEST_LINE + "b;\n\n", 2,
+     std::vector<std::string>{"a", "b"}},
+    {"empty file", "", 4, std::vector<std::string>{}},
+    {"invalid line", EPD_TEST_LINE + "a;\n8/8/8/8/8/8/8/8 w - - id b;\n" + EPD_TEST_LINE + "c;\n", 2, std::nullopt},
+};
+
+void testEpdFile(std::ostream &out)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "chess_cpp_epd_test.epd";
+    for (const EpdFileTestCase &testCase : EPD_FILE_TEST_CASES)
+    {
+        {
+            // Binary so that the line endings are written unchanged
+            std::ofstream file{path, std::ios::binary | std::ios::trunc};
+            file << testCase.contents;
+        }
+
+        std::optional<std::vector<std::string>> ids;
+        try
+        {
+            const EpdFile file{path.string()};
+            ids.emplace();
+            for (const EpdEntry &entry : file.load(testCase.threadCount))
+            {
+                ids->emplace_back(entry.id);
+            }
+        }
+        catch (const std::invalid_argument &)
+        {
+            ids.reset();
+        }
+
+        out << "EpdFile::load " << testCase.description << " ";
+        if (ids == testCase.expectedIds)
+        {
+            out << "PASSED";
+            passedTests++;
+        }
+        else
+        {
+            out << "FAILED (expected " << (testCase.expectedIds ? testCase.expectedIds->size() : 0) << " entries"
+                << (testCase.expectedIds ? "" : " and an error") << ", got " << (ids ? ids->size() : 0) << " entries"
+                << (ids ? "" : " and an error") << ")";
+            failedTests++;
+        }
+        out << "\n";
+    }
+    std::filesystem::remove(path);
+}
+
+#ifdef __AVX2__
+/**
+ * Whether the Kogge-Stone attack maps are the same as the lookup attack maps, with and without the king of the side to
+ * move (which is how the king's moves are generated)
+ */
+bool attackMapsMatch(Board &board)
+{
+    using movegen::AttackKernel;
+    const Bitboard occupancy = board.getPieces();
+    const Bitboard occupancyWithoutKing = occupancy & ~bitboards::withSquare(board.getKingSquare(board.sideToMove));
+    return movegen::computeAttackMaps<AttackKernel::KOGGE_STONE>(board, occupancy) ==
+               movegen::computeAttackMaps<AttackKernel::LOOKUP>(board, occupancy) &&
+           movegen::computeAttackMaps<AttackKernel::KOGGE_STONE>(board, occupancyWithoutKing) ==
+               movegen::computeAttackMaps<AttackKernel::LOOKUP>(board, occupancyWithoutKing);
+}
+
+void testAttackMaps(uint8_t depth, const std::string &fen, std::ostream &out)
+{
+    Board board;
+    board.loadFen(fen);
+    reportTreeCheck("attack maps", fen, forEachPerftNode(board, depth, attackMapsMatch), out);
+}
+#endif
+
+const std::vector<PerftTestPosition> PERFT_TEST_POSITIONS = {
+    {6, std::string{STARTING_POSITION_FEN}, 119060324},
     // Test positions
-    test(5,
-         "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0",
-         193690690);
-    test(6, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0", 11030083);
-    test(5, "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
-         15833292);
-    test(5, "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
-         89941194);
-    test(5,
-         "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 "
-         "10",
-         164075551);
-    test(6, "2bqk3/prpppp2/2n4b/8/1P6/8/2PPPPPN/RNBQKBNr b Q - 0 15", 367853606);
-    test(5,
-         "r3k1nr/p1ppprpp/Q1n1b1BP/Pp1bP3/2qPrP1b/NP1p1pP1/P1P1P1pP/R1BQKBNR w "
-         "KQkq - 0 1",
-         71379963);
-    test(6, "8/k1p5/8/KP5r/8/8/6p1/4R2N w - - 0 1", 64081091);
-    test(5, "q6r/1k6/8/8/8/8/1K6/Q6R w - - 0 1", 16871195);
-    test(7, "k7/pppppppp/8/8/8/8/PPPPPPPP/K7 w - - 0 1", 303041957);
+    {5, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 0", 193690690},
+    {6, "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 0", 11030083},
+    {5, "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 15833292},
+    {5, "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 89941194},
+    {5, "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 164075551},
+    {6, "2bqk3/prpppp2/2n4b/8/1P6/8/2PPPPPN/RNBQKBNr b Q - 0 15", 367853606},
+    {5, "r3k1nr/p1ppprpp/Q1n1b1BP/Pp1bP3/2qPrP1b/NP1p1pP1/P1P1P1pP/R1BQKBNR w KQkq - 0 1", 71379963},
+    {6, "8/k1p5/8/KP5r/8/8/6p1/4R2N w - - 0 1", 64081091},
+    {5, "q6r/1k6/8/8/8/8/1K6/Q6R w - - 0 1", 16871195},
+    {7, "k7/pppppppp/8/8/8/8/PPPPPPPP/K7 w - - 0 1", 303041957},
 
     // Positions from real games
 
     // https://lichess.org/QR5UbqUY#16
-    test(5, "r1bqk2r/ppp2ppp/2n1pn2/8/QbBP4/2N2N2/PP3PPP/R1B2RK1 w kq - 4 9",
-         108181315);
+    {5, "r1bqk2r/ppp2ppp/2n1pn2/8/QbBP4/2N2N2/PP3PPP/R1B2RK1 w kq - 4 9", 108181315},
 
     // https://lichess.org/INY3KINN#51
-    test(6, "2rr2k1/5np1/1pp1pn1p/p4p2/P1PP4/3NP1P1/5PP1/2RRB1K1 b - - 0 26",
-         406683732);
+    {6, "2rr2k1/5np1/1pp1pn1p/p4p2/P1PP4/3NP1P1/5PP1/2RRB1K1 b - - 0 26", 406683732},
 
     // https://lichess.org/INY3KINN#115
-    test(6, "6k1/6p1/7p/2N3P1/PR6/5PK1/r5P1/6n1 b - - 2 58", 85338565);
+    {6, "6k1/6p1/7p/2N3P1/PR6/5PK1/r5P1/6n1 b - - 2 58", 85338565},
 
     // https://lichess.org/751DRMPG#29
-    test(5, "r2q1rk1/4bppp/1p2pn2/3pP3/2p2B2/4P2P/1PPNQPP1/R4RK1 b - - 0 15",
-         63507755);
+    {5, "r2q1rk1/4bppp/1p2pn2/3pP3/2p2B2/4P2P/1PPNQPP1/R4RK1 b - - 0 15", 63507755},
 
     // https://lichess.org/751DRMPG#89
-    test(6, "3Q4/5k1N/4q1p1/3pB3/8/5P2/r5P1/6K1 b - - 4 45", 509977948);
+    {6, "3Q4/5k1N/4q1p1/3pB3/8/5P2/r5P1/6K1 b - - 4 45", 509977948},
 
     // https://lichess.org/I5iGXY21#108
-    test(7, "8/8/8/p6p/P3R1r1/2k5/4K3/8 w - - 1 55", 234461080);
+    {7, "8/8/8/p6p/P3R1r1/2k5/4K3/8 w - - 1 55", 234461080},
 
     // Played in engine test game
-    test(5, "r2q1rk1/ppp2p1p/1bn5/7R/1P1p2b1/N1P5/P4QP1/R1B1KBN1 b Q - 0 19",
-         101255241);
+    {5, "r2q1rk1/ppp2p1p/1bn5/7R/1P1p2b1/N1P5/P4QP1/R1B1KBN1 b Q - 0 19", 101255241},
+};
+
+/**
+ * Runs a test on every test position on a pool of threads. The output of each position is buffered and printed in the
+ * order of the positions as soon as every earlier position has finished, so it reads the same as a sequential run.
+ */
+template <typename Test>
+void testPositionsConcurrently(unsigned int threadCount, Test &&test)
+{
+    const size_t count = PERFT_TEST_POSITIONS.size();
+    std::vector<std::ostringstream> outputs(count);
+    std::vector<bool> finished(count);
+    size_t nextToPrint = 0;
+    std::mutex outputMutex;
+    parallelFor(count, threadCount, [&](size_t i)
+                {
+                    test(PERFT_TEST_POSITIONS[i], outputs[i]);
+                    const std::lock_guard lock{outputMutex};
+                    finished[i] = true;
+                    while (nextToPrint < count && finished[nextToPrint])
+                    {
+                        std::cout << outputs[nextToPrint++].str() << std::flush;
+                    } });
+}
+
+// Size of the cache shared by the cached perft tests
+constexpr size_t TEST_PERFT_CACHE_SIZE_MB = 256;
+
+void runTests()
+{
+    passedTests = 0;
+    failedTests = 0;
+    const unsigned int threadCount = std::max(std::thread::hardware_concurrency(), 2u);
+
+    std::atomic<size_t> perftNodes = 0;
+    const auto perftStart = std::chrono::steady_clock::now();
+    testPositionsConcurrently(threadCount, [&](const PerftTestPosition &position, std::ostream &out)
+                              { perftNodes += test(position.depth, position.fen, position.expectedValue, out); });
+    const double perftSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - perftStart).count();
+    std::cout << "perft: " << perftNodes << " positions in " << perftSeconds << " s on " << threadCount
+              << " threads, " << static_cast<size_t>(perftNodes / perftSeconds) << " positions/s\n";
+
+    // The same positions again with one cache shared by every thread, which must give the same counts
+    PerftCache cache{TEST_PERFT_CACHE_SIZE_MB};
+    const auto cachedStart = std::chrono::steady_clock::now();
+    testPositionsConcurrently(threadCount, [&](const PerftTestPosition &position, std::ostream &out)
+                              { test(position.depth, position.fen, position.expectedValue, out, &cache); });
+    const double cachedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - cachedStart).count();
+    std::cout << "cached perft: " << cachedSeconds << " s (" << perftSeconds / cachedSeconds << "x), "
+              << cache.hits() << " of " << cache.probes() << " probes hit (" << cache.hitRate() * 100 << "%)\n";
+
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              { testMoveValidation(position.fen, out); });
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              {
+                                  // Every move is made, so this is much slower than perft at the same depth
+                                  testGivesCheck(position.depth - 1, position.fen, out); });
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              { testGenerationModes(position.depth - 2, position.fen, out); });
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              { testHash(position.depth - 2, position.fen, out); });
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              { testAttackersTo(position.depth - 2, position.fen, out); });
+    testSee();
+    testFenParsing();
+    testEpdOperation();
+    testEpdFile();
+#ifdef __AVX2__
+    testPositionsConcurrently(threadCount, [](const PerftTestPosition &position, std::ostream &out)
+                              { testAttackMaps(position.depth - 2, position.fen, out); });
+#endif
+    // Each of these already runs on every thread
+    for (const PerftTestPosition &position : PERFT_TEST_POSITIONS)
+    {
+        testConcurrentPerft(position.depth - 2, position.fen, threadCount);
+    }
 
     std::cout << "Tests run: " << (passedTests + failedTests)
               << ", Passed: " << passedTests
@@ -157,4 +966,4 @@ void runTests()
     {
         std::exit(1);
     }
-}
\ No newline at end of file
+}
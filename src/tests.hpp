@@ -1,15 +1,119 @@
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
+#include <iostream>
 #include <string>
+#include <vector>
 
-size_t runPerft(uint8_t depth, const std::string &fen, const std::string &moveSequence);
+class Board;
+class PerftCache;
 
-inline void runPerft(uint8_t depth, const std::string &fen)
+struct PerftTestPosition
 {
-    runPerft(depth, fen, "");
+    uint8_t depth;
+    std::string fen;
+    size_t expectedValue;
+};
+
+extern const std::vector<PerftTestPosition> PERFT_TEST_POSITIONS;
+
+/**
+ * Counts the positions reached after the given number of moves. Subtrees that are already in the cache are not counted
+ * again, and every counted subtree below the root is stored in it.
+ */
+size_t perft(Board &board, uint8_t depth, bool rootNode = true, bool output = true, PerftCache *cache = nullptr);
+
+/**
+ * Perft with the root moves split between a pool of threads, each with its own copy of the board. The divide output is
+ * printed in the same order as perft() once every root move has been counted.
+ */
+size_t parallelPerft(Board &board, uint8_t depth, unsigned int threadCount, bool output = true,
+                     PerftCache *cache = nullptr);
+
+/**
+ * Runs perft from the position after the move sequence and prints the total and time, on more than one thread if a
+ * thread count above 1 is given, and with a cache of the given size shared by the threads if it isn't 0
+ */
+size_t runPerft(uint8_t depth, const std::string &fen, const std::string &moveSequence, unsigned int threadCount = 1,
+                size_t cacheSizeMB = 0);
+
+inline void runPerft(uint8_t depth, const std::string &fen, unsigned int threadCount = 1, size_t cacheSizeMB = 0)
+{
+    runPerft(depth, fen, "", threadCount, cacheSizeMB);
 }
 
-void test(uint8_t depth, const std::string &fen, size_t expectedValue);
+/**
+ * Checks perft of the position against the expected value, and returns the number of positions reached
+ */
+size_t test(uint8_t depth, const std::string &fen, size_t expectedValue, std::ostream &out = std::cout,
+            PerftCache *cache = nullptr);
+
+/**
+ * Runs perft on the same position from several threads at once, each with its own board, and checks that every thread
+ * gets the same count as a single threaded run. Data races in move generation are best found by running this in a
+ * build with ENABLE_THREAD_SANITIZER.
+ */
+void testConcurrentPerft(uint8_t depth, const std::string &fen, unsigned int threadCount);
+
+/**
+ * Checks Board::isPseudoLegal() and Board::isLegal() against the move generator in positions reached by playing random
+ * moves from the given position, using generated moves, moves from the previous position and random moves
+ */
+void testMoveValidation(const std::string &fen, std::ostream &out = std::cout);
+
+/**
+ * Checks Board::givesCheck() against making each move in the perft tree of the given position to the given depth
+ */
+void testGivesCheck(uint8_t depth, const std::string &fen, std::ostream &out = std::cout);
+
+/**
+ * Checks the captures, quiets and evasions generation modes, countLegalMoves() and pseudo-legal generation against
+ * generating all legal moves in every position of the perft tree of the given position to the given depth
+ */
+void testGenerationModes(uint8_t depth, const std::string &fen, std::ostream &out = std::cout);
+
+/**
+ * Checks the incrementally updated hash against the hash computed from scratch in every position of the perft tree of
+ * the given position to the given depth
+ */
+void testHash(uint8_t depth, const std::string &fen, std::ostream &out = std::cout);
+
+/**
+ * Checks Board::attackersTo() against Board::isSquareAttacked() for every square in every position of the perft tree of
+ * the given position to the given depth
+ */
+void testAttackersTo(uint8_t depth, const std::string &fen, std::ostream &out = std::cout);
+
+/**
+ * Checks the static exchange evaluation of captures and promotions with known results
+ */
+void testSee(std::ostream &out = std::cout);
+
+/**
+ * Checks that FEN and EPD positions load with the expected fields, and that malformed ones are rejected
+ */
+void testFenParsing(std::ostream &out = std::cout);
+
+/**
+ * Checks the operands that epdOperation() finds in EPD operations
+ */
+void testEpdOperation(std::ostream &out = std::cout);
+
+/**
+ * Checks that EpdFile::load() finds every line of files with different line endings and thread counts
+ */
+void testEpdFile(std::ostream &out = std::cout);
+
+#ifdef __AVX2__
+/**
+ * Checks the Kogge-Stone attack maps against the lookup attack maps in every position of the perft tree of the given
+ * position to the given depth
+ */
+void testAttackMaps(uint8_t depth, const std::string &fen, std::ostream &out = std::cout);
+#endif
 
+/**
+ * Runs every test, with the positions of each test spread over all threads, and exits with status 1 if any test fails
+ */
 void runTests();
\ No newline at end of file